@@ -0,0 +1,123 @@
+/* accuracy_test.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Accuracy test for the sample type (see sample.h). Every lexicon word
+// is synthesized and either written out as the reference, or compared
+// with a reference written by the double build. The test fails if the
+// signal-to-noise ratio of any word is below the given bound.
+//
+//   ./accuracy_double --write reference.raw
+//   ./accuracy_float --compare reference.raw --min-snr 60
+// =====================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lexicon.h"
+#include "synthesizer.h"
+
+int main(int argc, char **argv) {
+    const char *write_path = NULL;
+    const char *compare_path = NULL;
+    double min_snr = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            write_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--min-snr") == 0 && i + 1 < argc) {
+            min_snr = atof(argv[++i]);
+        } else {
+            write_path = compare_path = NULL;
+            break;
+        }
+    }
+    if ((write_path == NULL) == (compare_path == NULL)) {
+        fprintf(stderr, "Usage: %s --write FILE | --compare FILE [--min-snr DB]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(write_path ? write_path : compare_path, write_path ? "wb" : "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open %s.\n", write_path ? write_path : compare_path);
+        return 1;
+    }
+
+    KlattEngine engine;
+    initialize_synthesis_engine(&engine, NULL);
+
+    int failed = 0;
+    double worst_snr = INFINITY;
+    const char *worst_word = "";
+    for (int w = 0; w < lexicon_num_words && !failed; w++) {
+        const LexiconWord *word = &lexicon_words[w];
+        double *samples = NULL;
+        int num_samples = synthesize_phrase_samples(&engine, &word->diphones, word->num_diphones, 1, &samples);
+        if (num_samples < 0) {
+            failed = 1;
+            break;
+        }
+
+        if (write_path) {
+            if (fwrite(samples, sizeof(double), num_samples, file) != (size_t)num_samples) {
+                fprintf(stderr, "Error: Could not write %s.\n", write_path);
+                failed = 1;
+            }
+            free(samples);
+            continue;
+        }
+
+        double *reference = (double *)malloc((num_samples > 0 ? num_samples : 1) * sizeof(double));
+        if (reference == NULL || fread(reference, sizeof(double), num_samples, file) != (size_t)num_samples) {
+            fprintf(stderr, "Error: Reference %s is shorter than the output.\n", compare_path);
+            failed = 1;
+        } else {
+            double signal = 0.0;
+            double noise = 0.0;
+            for (int i = 0; i < num_samples; i++) {
+                signal += reference[i] * reference[i];
+                noise += (samples[i] - reference[i]) * (samples[i] - reference[i]);
+            }
+            double snr = (noise > 0.0) ? 10.0 * log10(signal / noise) : INFINITY;
+            if (snr < worst_snr) {
+                worst_snr = snr;
+                worst_word = word->name;
+            }
+        }
+        free(reference);
+        free(samples);
+    }
+    fclose(file);
+    free_synthesis_engine(&engine);
+
+    if (failed) {
+        return 1;
+    }
+    if (write_path) {
+        printf("%s samples: wrote reference for %d words to %s\n", KLATT_SAMPLE_TYPE_NAME, lexicon_num_words, write_path);
+        return 0;
+    }
+    int passed = (worst_snr >= min_snr);
+    printf("%s samples: worst SNR %.1f dB (%s), bound %.1f dB: %s\n",
+           KLATT_SAMPLE_TYPE_NAME, worst_snr, worst_word, min_snr, passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
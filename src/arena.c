@@ -0,0 +1,163 @@
+/* arena.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "arena.h"
+
+// A block that filled up while its allocations are still in use
+struct ArenaBlock {
+    ArenaBlock *previous;
+    char *base;
+    size_t size;
+    size_t used;
+};
+
+// Uses the size bytes at memory, which the caller owns. The arena does
+// not grow beyond them.
+void arena_init(Arena *arena, void *memory, size_t size) {
+    arena->base = (char *)memory;
+    arena->size = size;
+    arena->used = 0;
+    arena->previous = NULL;
+    arena->previous_used = 0;
+    arena->high_water = 0;
+    arena->blocks_allocated = 0;
+    arena->owned = 0;
+}
+
+// Starts an empty owning arena; nothing is allocated until it is used
+void arena_create(Arena *arena) {
+    arena_init(arena, NULL, 0);
+    arena->owned = 1;
+}
+
+void arena_destroy(Arena *arena) {
+    arena_reset(arena);
+    if (arena->owned) {
+        free(arena->base);
+        arena->base = NULL;
+        arena->size = 0;
+    }
+}
+
+// Starts a block with room for size bytes. The current block is kept
+// until the arena is rewound past it, so allocations and marks in it stay
+// valid. Returns -1 if the arena cannot grow.
+static int arena_grow(Arena *arena, size_t size) {
+    if (!arena->owned) {
+        return -1;
+    }
+    size_t block_size = (arena->size > ARENA_MIN_BLOCK / 2) ? 2 * arena->size : ARENA_MIN_BLOCK;
+    if (block_size < size + ARENA_ALIGNMENT) {
+        block_size = size + ARENA_ALIGNMENT;
+    }
+    char *memory = (char *)malloc(block_size);
+    if (memory == NULL) {
+        return -1;
+    }
+    arena->blocks_allocated++;
+    if (arena->base != NULL) {
+        ArenaBlock *full = (ArenaBlock *)malloc(sizeof(ArenaBlock));
+        if (full == NULL) {
+            free(memory);
+            return -1;
+        }
+        full->previous = arena->previous;
+        full->base = arena->base;
+        full->size = arena->size;
+        full->used = arena->used;
+        arena->previous = full;
+        arena->previous_used += arena->used;
+    }
+    arena->base = memory;
+    arena->size = block_size;
+    arena->used = 0;
+    return 0;
+}
+
+// Returns size bytes aligned to ARENA_ALIGNMENT, or NULL if the memory
+// cannot be allocated. The memory is not cleared.
+void *arena_alloc(Arena *arena, size_t size) {
+    // A fresh owning arena has no block yet, so start one
+    int fits = 0;
+    size_t padding = 0;
+    if (arena->base != NULL) {
+        uintptr_t address = (uintptr_t)(arena->base + arena->used);
+        padding = (ARENA_ALIGNMENT - address % ARENA_ALIGNMENT) % ARENA_ALIGNMENT;
+        fits = size <= arena->size - arena->used && padding <= arena->size - arena->used - size;
+    }
+    if (!fits) {
+        if (arena_grow(arena, size) != 0) {
+            return NULL;
+        }
+        uintptr_t address = (uintptr_t)arena->base;
+        padding = (ARENA_ALIGNMENT - address % ARENA_ALIGNMENT) % ARENA_ALIGNMENT;
+    }
+    void *block = arena->base + arena->used + padding;
+    arena->used += padding + size;
+    if (arena->previous_used + arena->used > arena->high_water) {
+        arena->high_water = arena->previous_used + arena->used;
+    }
+    return block;
+}
+
+ArenaMark arena_mark(const Arena *arena) {
+    ArenaMark mark;
+    mark.base = arena->base;
+    mark.used = arena->used;
+    return mark;
+}
+
+// Releases everything allocated since mark was taken
+void arena_rewind(Arena *arena, ArenaMark mark) {
+    // Drop the blocks started since the mark. A mark taken before the
+    // first block (base NULL) keeps the oldest one.
+    while (arena->base != mark.base && arena->previous != NULL) {
+        ArenaBlock *full = arena->previous;
+        free(arena->base);
+        arena->base = full->base;
+        arena->size = full->size;
+        arena->previous = full->previous;
+        arena->previous_used -= full->used;
+        free(full);
+    }
+    arena->used = (arena->base == mark.base) ? mark.used : 0;
+
+    // Once empty, resize the block to the peak so it holds a whole
+    // utterance next time
+    if (arena->owned && arena->previous == NULL && arena->used == 0 && arena->size < arena->high_water) {
+        char *memory = (char *)malloc(arena->high_water + ARENA_ALIGNMENT);
+        if (memory != NULL) {
+            free(arena->base);
+            arena->base = memory;
+            arena->size = arena->high_water + ARENA_ALIGNMENT;
+            arena->blocks_allocated++;
+        }
+    }
+}
+
+// Releases every allocation at once
+void arena_reset(Arena *arena) {
+    ArenaMark empty;
+    empty.base = NULL;
+    empty.used = 0;
+    arena_rewind(arena, empty);
+}
@@ -0,0 +1,68 @@
+/* arena.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Bump allocator for per-utterance scratch memory. Allocations are
+// carved from a block in order and released together, by arena_reset()
+// or by rewinding to an earlier arena_mark(), so the hot path does no
+// malloc() or free() and cannot fragment the heap.
+//
+// An arena either uses a fixed buffer owned by the caller (arena_init)
+// or owns its memory (arena_create). An owning arena grows by starting a
+// bigger block when one is full, so earlier allocations stay valid, and
+// once it is empty again it is resized to the most it has ever held.
+// After the first utterances it therefore settles to a single block.
+// =====================================================================
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 16         // Enough for any type, including SIMD vectors
+#define ARENA_MIN_BLOCK (64 * 1024) // Smallest block an owning arena allocates
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    char *base;            // Current block
+    size_t size;
+    size_t used;
+    ArenaBlock *previous;  // Full blocks still in use, newest first
+    size_t previous_used;  // Bytes in use in those blocks
+    size_t high_water;     // Most bytes in use at once
+    size_t blocks_allocated; // Calls to malloc() so far
+    int owned;             // Blocks come from malloc() and the arena can grow
+} Arena;
+
+// Position to rewind to, from arena_mark()
+typedef struct {
+    char *base;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena *arena, void *memory, size_t size);
+void arena_create(Arena *arena);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+ArenaMark arena_mark(const Arena *arena);
+void arena_rewind(Arena *arena, ArenaMark mark);
+void arena_reset(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,174 @@
+/* arpabet.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "arpabet.h"
+#include "lexicon.h"
+
+#define ARPABET_SPACE " \t\r\n"
+
+// ARPAbet symbols whose table entries are named differently
+static const struct {
+    const char *symbol;
+    const char *phoneme;
+} arpabet_aliases[] = {
+    {"HH", "H_FRICATIVE"},
+    {"SIL", "SILENCE"},
+    {"PAU", "SILENCE"},
+};
+
+// Compares symbol with name, or with the part of name before the first
+// underscore when prefix is set, ignoring case
+static int symbol_matches(const char *symbol, size_t length, const char *name, int prefix) {
+    size_t name_length = prefix ? strcspn(name, "_") : strlen(name);
+    if (name_length != length) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (toupper((unsigned char)symbol[i]) != name[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const PhonemeParams *arpabet_find_phoneme(const char *symbol, size_t length) {
+    for (size_t i = 0; i < sizeof(arpabet_aliases) / sizeof(arpabet_aliases[0]); i++) {
+        if (symbol_matches(symbol, length, arpabet_aliases[i].symbol, 0)) {
+            symbol = arpabet_aliases[i].phoneme;
+            length = strlen(symbol);
+            break;
+        }
+    }
+    for (int i = 0; i < lexicon_num_phonemes; i++) {
+        if (symbol_matches(symbol, length, lexicon_phonemes[i].name, 0)) {
+            return lexicon_phonemes[i].params;
+        }
+    }
+    for (int i = 0; i < lexicon_num_phonemes; i++) {
+        if (symbol_matches(symbol, length, lexicon_phonemes[i].name, 1)) {
+            return lexicon_phonemes[i].params;
+        }
+    }
+    return NULL;
+}
+
+// Lower case short name of a phoneme for diphone names, e.g. "eh" for
+// EH_VOWEL and "sil" for SILENCE as in the built-in words
+static size_t phoneme_short_name(const PhonemeParams *params, char *name, size_t size) {
+    int index = lexicon_phoneme_index(params);
+    const char *full = (index >= 0) ? lexicon_phonemes[index].name : "?";
+    if (strcmp(full, "SILENCE") == 0) {
+        full = "SIL";
+    }
+    size_t length = strcspn(full, "_");
+    if (length >= size) {
+        length = size - 1;
+    }
+    for (size_t i = 0; i < length; i++) {
+        name[i] = (char)tolower((unsigned char)full[i]);
+    }
+    name[length] = '\0';
+    return length;
+}
+
+int arpabet_word_diphones(const char *phonemes, size_t length, Arena *arena, const Diphone **diphones, int *num_diphones) {
+    // Every phoneme but the first ends a diphone, and each takes at least
+    // two bytes with its separator, so this bounds the count
+    int max_diphones = (int)(length / 2) + 1;
+    Diphone *sequence = (Diphone *)arena_alloc(arena, max_diphones * sizeof(Diphone));
+    if (sequence == NULL) {
+        fprintf(stderr, "Error: Phoneme text is too long.\n");
+        return -1;
+    }
+
+    const PhonemeParams *previous = NULL;
+    int count = 0;
+    size_t position = 0;
+    while (position < length) {
+        position += strspn(phonemes + position, ARPABET_SPACE);
+        size_t symbol_length = strcspn(phonemes + position, ARPABET_SPACE);
+        if (symbol_length > length - position) {
+            symbol_length = length - position;
+        }
+        if (symbol_length == 0) {
+            break;
+        }
+        const char *symbol = phonemes + position;
+        position += symbol_length;
+
+        const PhonemeParams *phoneme = arpabet_find_phoneme(symbol, symbol_length);
+        if (phoneme == NULL) {
+            fprintf(stderr, "Error: Unknown phoneme '%.*s'.\n", (int)symbol_length, symbol);
+            return -1;
+        }
+        if (previous != NULL) {
+            char p1[MAX_WORD_NAME];
+            char p2[MAX_WORD_NAME];
+            size_t name_length = phoneme_short_name(previous, p1, sizeof(p1)) + 1
+                               + phoneme_short_name(phoneme, p2, sizeof(p2)) + 1;
+            char *name = (char *)arena_alloc(arena, name_length);
+            if (name == NULL) {
+                fprintf(stderr, "Error: Phoneme text is too long.\n");
+                return -1;
+            }
+            snprintf(name, name_length, "%s-%s", p1, p2);
+
+            Diphone *diphone = &sequence[count++];
+            diphone->name = name;
+            diphone->p1 = previous;
+            diphone->p2 = phoneme;
+            diphone->start_frames = ARPABET_START_FRAMES;
+            diphone->transition_frames = ARPABET_TRANSITION_FRAMES;
+            diphone->end_frames = ARPABET_END_FRAMES;
+        }
+        previous = phoneme;
+    }
+    if (count == 0) {
+        fprintf(stderr, "Error: A word needs at least two phonemes.\n");
+        return -1;
+    }
+    *diphones = sequence;
+    *num_diphones = count;
+    return 0;
+}
+
+int arpabet_phrase_diphones(const char *text, Arena *arena, const Diphone **word_diphones, int *num_diphones, int max_words) {
+    int num_words = 0;
+    const char *word = text;
+    for (;;) {
+        const char *separator = strchr(word, ARPABET_WORD_SEPARATOR);
+        size_t length = separator ? (size_t)(separator - word) : strlen(word);
+        if (num_words >= max_words) {
+            fprintf(stderr, "Error: Phrase has more than %d words.\n", max_words);
+            return -1;
+        }
+        if (arpabet_word_diphones(word, length, arena, &word_diphones[num_words], &num_diphones[num_words]) != 0) {
+            return -1;
+        }
+        num_words++;
+        if (separator == NULL) {
+            return num_words;
+        }
+        word = separator + 1;
+    }
+}
@@ -0,0 +1,55 @@
+/* arpabet.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Runtime front end for words that are not in the lexicon. A word is
+// written as a sequence of phoneme symbols, e.g. "HH EH L OW SIL", and
+// turned into the diphones between neighbouring phonemes with the usual
+// frame timings. A symbol is the name of a PHONEME_* table entry, either
+// in full ("T_PUNCTUAL") or before the underscore ("AH" for AH_VOWEL;
+// the first entry wins, so "T" is T_BURST), case is ignored, and the
+// ARPAbet symbols HH, SIL and PAU are accepted as well. The diphones and
+// their names are allocated from an arena, so nothing is freed.
+// =====================================================================
+#ifndef ARPABET_H
+#define ARPABET_H
+
+#include "phonemes.h"
+#include "arena.h"
+
+#define ARPABET_START_FRAMES 10 // Timings of the generated diphones, as used by most words
+#define ARPABET_TRANSITION_FRAMES 5
+#define ARPABET_END_FRAMES 10
+#define ARPABET_WORD_SEPARATOR ','
+
+// Returns the phoneme for a symbol, or NULL if there is none
+const PhonemeParams *arpabet_find_phoneme(const char *symbol, size_t length);
+
+// Builds the diphones of one word from length bytes of phoneme symbols
+// separated by spaces. Returns -1 (after printing an error) if a symbol
+// is unknown, there are fewer than two phonemes or the arena is full.
+int arpabet_word_diphones(const char *phonemes, size_t length, Arena *arena, const Diphone **diphones, int *num_diphones);
+
+// Builds a phrase of words separated by ARPABET_WORD_SEPARATOR, e.g.
+// "HH EH L OW SIL, W ER L D SIL". Returns the number of words, or -1 on
+// error or if there are more than max_words.
+int arpabet_phrase_diphones(const char *text, Arena *arena, const Diphone **word_diphones, int *num_diphones, int max_words);
+
+#endif // ARPABET_H
@@ -0,0 +1,207 @@
+/* batch.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Worker pool that renders a list of phrases. Each worker owns its own
+// KlattEngine and pulls the next phrase from a shared index, so the pool
+// load-balances phrases of different lengths across all cores.
+// =====================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include "synthesizer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// Shared state of a running batch
+typedef struct {
+    const BatchPhrase *phrases;
+    int num_phrases;
+    const KlattOptions *options;
+    PcmCache *cache;
+    const SegmentStore *segments;
+    int next_phrase;
+    int num_rendered;
+    int num_failed;
+    long total_samples;
+    double *latencies; // Render time of each phrase in seconds
+    KlattStats engine_stats;
+    pthread_mutex_t lock;
+} BatchQueue;
+
+// Returns the number of online processors (at least one)
+int batch_default_thread_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
+}
+
+static double batch_now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *batch_worker(void *arg) {
+    BatchQueue *queue = (BatchQueue *)arg;
+    KlattEngine engine;
+    initialize_synthesis_engine(&engine, queue->options);
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next_phrase++;
+        pthread_mutex_unlock(&queue->lock);
+        if (index >= queue->num_phrases) {
+            break;
+        }
+
+        const BatchPhrase *phrase = &queue->phrases[index];
+        double start = batch_now_seconds();
+        int num_samples;
+        if (queue->segments != NULL) {
+            num_samples = synthesize_phrase_and_save_segments(queue->segments, &engine, phrase->filename,
+                                                              phrase->word_diphones, phrase->num_diphones,
+                                                              phrase->num_words);
+        } else {
+            num_samples = synthesize_phrase_and_save_cached(queue->cache, &engine, phrase->filename,
+                                                            phrase->word_diphones, phrase->num_diphones,
+                                                            phrase->num_words);
+        }
+        // Each phrase has its own slot, so no lock is needed
+        queue->latencies[index] = batch_now_seconds() - start;
+
+        pthread_mutex_lock(&queue->lock);
+        if (num_samples < 0) {
+            queue->num_failed++;
+        } else {
+            queue->num_rendered++;
+            queue->total_samples += num_samples;
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    KlattStats stats;
+    synthesis_engine_stats(&engine, &stats);
+    free_synthesis_engine(&engine);
+    pthread_mutex_lock(&queue->lock);
+    klatt_stats_merge(&queue->engine_stats, &stats);
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+static int compare_seconds(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Renders every phrase to its WAV file using num_threads workers
+// (0 selects one worker per core), each with an engine initialized with
+// options (NULL for defaults). Rendered phrases are shared through cache
+// unless it is NULL. If segments is not NULL, phrases are assembled from
+// its pre-rendered words instead. Returns 0 if every phrase was written.
+int run_batch(const BatchPhrase *phrases, int num_phrases, int num_threads, const KlattOptions *options, PcmCache *cache, const SegmentStore *segments, BatchStats *stats) {
+    if (num_threads <= 0) {
+        num_threads = batch_default_thread_count();
+    }
+    if (num_threads > num_phrases && num_phrases > 0) {
+        num_threads = num_phrases;
+    }
+
+    BatchQueue queue = {0};
+    queue.phrases = phrases;
+    queue.num_phrases = num_phrases;
+    queue.options = options;
+    queue.cache = cache;
+    queue.segments = segments;
+    queue.latencies = (double *)calloc(num_phrases > 0 ? num_phrases : 1, sizeof(double));
+    pthread_mutex_init(&queue.lock, NULL);
+
+    pthread_t *threads = (pthread_t *)calloc(num_threads, sizeof(pthread_t));
+    if (threads == NULL || queue.latencies == NULL) {
+        fprintf(stderr, "Error: Could not allocate batch worker threads.\n");
+        free(threads);
+        free(queue.latencies);
+        pthread_mutex_destroy(&queue.lock);
+        return -1;
+    }
+
+    double start = batch_now_seconds();
+    int num_started = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, batch_worker, &queue) != 0) {
+            fprintf(stderr, "Error: Could not start batch worker %d.\n", i);
+            break;
+        }
+        num_started++;
+    }
+    // Fall back to rendering on the calling thread if no worker started
+    if (num_started == 0) {
+        batch_worker(&queue);
+    }
+    for (int i = 0; i < num_started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = batch_now_seconds() - start;
+
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+
+    if (stats) {
+        stats->num_threads = (num_started > 0) ? num_started : 1;
+        stats->num_rendered = queue.num_rendered;
+        stats->num_failed = queue.num_failed;
+        stats->total_samples = queue.total_samples;
+        stats->sample_rate = options ? options->sample_rate : SAMPLE_RATE;
+        stats->wall_seconds = elapsed;
+        stats->engine_stats = queue.engine_stats;
+
+        // Nearest-rank percentiles of the phrase render times: the sample
+        // at rank ceil(p * n), counted in integers to stay exact
+        qsort(queue.latencies, num_phrases, sizeof(double), compare_seconds);
+        int rank_p99 = (int)(((long long)num_phrases * 99 + 99) / 100);
+        stats->latency_p50 = (num_phrases > 0) ? queue.latencies[(num_phrases - 1) / 2] : 0.0;
+        stats->latency_p99 = (num_phrases > 0) ? queue.latencies[rank_p99 - 1] : 0.0;
+        stats->latency_max = (num_phrases > 0) ? queue.latencies[num_phrases - 1] : 0.0;
+
+        struct rusage usage;
+        stats->peak_rss_kb = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+    }
+    free(queue.latencies);
+    return (queue.num_failed == 0) ? 0 : -1;
+}
+
+// Prints utterances per second and the realtime factor
+// (seconds of audio produced per second of wall time)
+void print_batch_stats(FILE *out, const BatchStats *stats) {
+    double audio_seconds = (stats->sample_rate > 0) ? (double)stats->total_samples / stats->sample_rate : 0.0;
+    double utterances_per_second = (stats->wall_seconds > 0.0) ? stats->num_rendered / stats->wall_seconds : 0.0;
+    double realtime_factor = (stats->wall_seconds > 0.0) ? audio_seconds / stats->wall_seconds : 0.0;
+
+    fprintf(out, "Batch complete: %d utterances (%d failed) in %.3f s using %d threads\n",
+            stats->num_rendered, stats->num_failed, stats->wall_seconds, stats->num_threads);
+    fprintf(out, "Throughput: %.1f utterances/sec, %.1f s of audio, realtime factor %.1fx\n",
+            utterances_per_second, audio_seconds, realtime_factor);
+    fprintf(out, "Latency per phrase: p50 %.3f ms, p99 %.3f ms, max %.3f ms; peak RSS %.1f MB\n",
+            stats->latency_p50 * 1e3, stats->latency_p99 * 1e3, stats->latency_max * 1e3, stats->peak_rss_kb / 1024.0);
+}
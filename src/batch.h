@@ -0,0 +1,66 @@
+/* batch.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Multi-threaded batch rendering of many phrases
+// =====================================================================
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include "phonemes.h"
+#include "synthesizer.h"
+#include "pcmcache.h"
+#include "segments.h"
+
+#define MAX_PHRASE_WORDS 16
+#define MAX_BATCH_FILENAME 256
+
+// One phrase to be rendered and the WAV file it is written to
+typedef struct {
+    char filename[MAX_BATCH_FILENAME];
+    const Diphone *word_diphones[MAX_PHRASE_WORDS];
+    int num_diphones[MAX_PHRASE_WORDS];
+    int num_words;
+} BatchPhrase;
+
+// Aggregate results of a batch run
+typedef struct {
+    int num_threads;
+    int num_rendered;
+    int num_failed;
+    long total_samples;     // Samples written across all phrases
+    int sample_rate;        // Rate of the written phrases in Hz
+    double wall_seconds;    // Elapsed time for the whole batch
+    double latency_p50;     // Median time to render and write one phrase, in seconds
+    double latency_p99;     // 99th percentile of the same
+    double latency_max;     // Slowest phrase
+    long peak_rss_kb;       // Peak resident set size of the process
+    KlattStats engine_stats; // Instrumentation counters of all workers (KLATT_STATS builds)
+} BatchStats;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+int batch_default_thread_count(void);
+int run_batch(const BatchPhrase *phrases, int num_phrases, int num_threads, const KlattOptions *options, PcmCache *cache, const SegmentStore *segments, BatchStats *stats);
+void print_batch_stats(FILE *out, const BatchStats *stats);
+
+#endif // BATCH_H
@@ -0,0 +1,344 @@
+/* daemon.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "daemon.h"
+
+#define DAEMON_MAX_CONNECTIONS 64
+#define DAEMON_ACCEPT_BACKOFF_NS 100000000 // Wait after accept() fails, e.g. out of file descriptors
+
+typedef struct DaemonServer DaemonServer;
+
+// A connection slot. The thread is joined before the slot is reused and
+// before the daemon returns.
+typedef struct {
+    DaemonServer *server;
+    pthread_t thread;
+    int fd;       // -1 once the thread has closed it
+    int used;     // The thread has been started and not yet joined
+    int finished; // The thread has returned from its loop
+} DaemonConnection;
+
+// Shared by all connection threads
+struct DaemonServer {
+    KlattOptions options;
+    WordLookup lookup;
+    pthread_mutex_t lookup_lock; // The lookup may fill caches, e.g. of a voice bank
+    pthread_mutex_t connections_lock; // Guards the fd and finished fields of the slots
+    DaemonConnection connections[DAEMON_MAX_CONNECTIONS];
+};
+
+static volatile sig_atomic_t daemon_stopping = 0;
+
+static void handle_stop_signal(int signum) {
+    (void)signum;
+    daemon_stopping = 1;
+}
+
+static void put_le32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+// Sends all of the bytes. Returns -1 if the client has gone.
+static int send_all(int fd, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return 0;
+}
+
+static int send_reply_header(int fd, int status, int sample_rate) {
+    uint8_t header[8];
+    put_le32(header, status);
+    put_le32(header + 4, sample_rate);
+    return send_all(fd, header, sizeof(header));
+}
+
+// PcmSink that sends each block to the client as soon as it is rendered
+static int pcm_sink_socket(void *user_data, const int16_t *samples, int num_samples) {
+    int fd = *(const int *)user_data;
+    uint8_t block[4 + 2 * DAEMON_MAX_BLOCK_SAMPLES];
+    // Blocks are one frame or one pause, so they fit, but split anyway
+    int max_samples = (int)((sizeof(block) - 4) / 2);
+    for (int done = 0; done < num_samples; done += max_samples) {
+        int n = (num_samples - done < max_samples) ? num_samples - done : max_samples;
+        put_le32(block, n);
+        for (int i = 0; i < n; i++) {
+            uint16_t sample = (uint16_t)samples[done + i];
+            block[4 + 2 * i] = (uint8_t)sample;
+            block[5 + 2 * i] = (uint8_t)(sample >> 8);
+        }
+        if (send_all(fd, block, 4 + 2 * (size_t)n) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Answers one request line. Returns -1 if the connection should close.
+static int serve_request(DaemonServer *server, KlattEngine *engine, int fd, char *line) {
+    const Diphone *word_diphones[DAEMON_MAX_WORDS];
+    int num_diphones[DAEMON_MAX_WORDS];
+    int num_words = 0;
+    int status = DAEMON_STATUS_OK;
+
+    char *save = NULL;
+    for (char *word = strtok_r(line, " \t\r", &save); word != NULL; word = strtok_r(NULL, " \t\r", &save)) {
+        if (num_words >= DAEMON_MAX_WORDS) {
+            status = DAEMON_STATUS_BAD_REQUEST;
+            break;
+        }
+        pthread_mutex_lock(&server->lookup_lock);
+        int found = server->lookup(word, &word_diphones[num_words], &num_diphones[num_words]);
+        pthread_mutex_unlock(&server->lookup_lock);
+        if (found != 0) {
+            status = DAEMON_STATUS_UNKNOWN_WORD;
+            break;
+        }
+        num_words++;
+    }
+    if (status == DAEMON_STATUS_OK && num_words == 0) {
+        status = DAEMON_STATUS_BAD_REQUEST;
+    }
+
+    if (send_reply_header(fd, status, engine->options.sample_rate) != 0) {
+        return -1;
+    }
+    if (status != DAEMON_STATUS_OK) {
+        return 0;
+    }
+    if (synthesize_phrase_streaming(engine, word_diphones, num_diphones, num_words, STREAM_GAIN, pcm_sink_socket, &fd) < 0) {
+        return -1;
+    }
+    uint8_t end[4] = {0, 0, 0, 0};
+    return send_all(fd, end, sizeof(end));
+}
+
+static void *connection_thread(void *arg) {
+    DaemonConnection *connection = (DaemonConnection *)arg;
+    DaemonServer *server = connection->server;
+    int fd = connection->fd;
+
+    KlattEngine engine;
+    initialize_synthesis_engine(&engine, &server->options);
+
+    char request[DAEMON_MAX_REQUEST];
+    size_t length = 0;
+    for (;;) {
+        ssize_t received = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        length += received;
+
+        // Serve every complete line in the buffer
+        char *start = request;
+        char *newline;
+        int failed = 0;
+        while (!failed && (newline = memchr(start, '\n', length - (start - request))) != NULL) {
+            *newline = '\0';
+            failed = serve_request(server, &engine, fd, start) != 0;
+            start = newline + 1;
+        }
+        length -= start - request;
+        memmove(request, start, length);
+        if (failed) {
+            break;
+        }
+        if (length == sizeof(request) - 1) {
+            // No newline within the longest allowed request
+            send_reply_header(fd, DAEMON_STATUS_BAD_REQUEST, engine.options.sample_rate);
+            break;
+        }
+    }
+    free_synthesis_engine(&engine);
+
+    // Close under the lock so the stopping daemon never shuts down a
+    // descriptor number that has been reused
+    pthread_mutex_lock(&server->connections_lock);
+    close(fd);
+    connection->fd = -1;
+    connection->finished = 1;
+    pthread_mutex_unlock(&server->connections_lock);
+    return NULL;
+}
+
+// Joins the threads of finished connections so their slots can be reused
+static void reap_connections(DaemonServer *server) {
+    for (int i = 0; i < DAEMON_MAX_CONNECTIONS; i++) {
+        DaemonConnection *connection = &server->connections[i];
+        pthread_mutex_lock(&server->connections_lock);
+        int finished = connection->used && connection->finished;
+        pthread_mutex_unlock(&server->connections_lock);
+        if (finished) {
+            pthread_join(connection->thread, NULL);
+            connection->used = 0;
+        }
+    }
+}
+
+// Starts a thread for a new connection. Returns -1 (having closed fd) if
+// there is no free slot or the thread cannot start.
+static int start_connection(DaemonServer *server, int fd) {
+    reap_connections(server);
+    DaemonConnection *connection = NULL;
+    for (int i = 0; i < DAEMON_MAX_CONNECTIONS && connection == NULL; i++) {
+        if (!server->connections[i].used) {
+            connection = &server->connections[i];
+        }
+    }
+    if (connection == NULL) {
+        fprintf(stderr, "Error: More than %d connections.\n", DAEMON_MAX_CONNECTIONS);
+        close(fd);
+        return -1;
+    }
+    connection->server = server;
+    connection->fd = fd;
+    connection->finished = 0;
+
+    // The thread inherits the blocked signals, so they reach accept()
+    sigset_t stop_signals, previous;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &previous);
+    int started = pthread_create(&connection->thread, NULL, connection_thread, connection);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (started != 0) {
+        fprintf(stderr, "Error: Could not start a connection thread.\n");
+        close(fd);
+        connection->fd = -1;
+        return -1;
+    }
+    connection->used = 1;
+    return 0;
+}
+
+// Ends every connection and waits for its thread, so nothing uses the
+// server or the word lookup after run_daemon() returns
+static void stop_connections(DaemonServer *server) {
+    pthread_mutex_lock(&server->connections_lock);
+    for (int i = 0; i < DAEMON_MAX_CONNECTIONS; i++) {
+        DaemonConnection *connection = &server->connections[i];
+        if (connection->used && connection->fd >= 0) {
+            // Wakes recv() and fails send(), so the thread leaves its loop
+            shutdown(connection->fd, SHUT_RDWR);
+        }
+    }
+    pthread_mutex_unlock(&server->connections_lock);
+    for (int i = 0; i < DAEMON_MAX_CONNECTIONS; i++) {
+        if (server->connections[i].used) {
+            pthread_join(server->connections[i].thread, NULL);
+            server->connections[i].used = 0;
+        }
+    }
+}
+
+// Serves requests on socket_path until SIGINT or SIGTERM. Returns -1 if
+// the socket cannot be set up.
+int run_daemon(const char *socket_path, const KlattOptions *options, WordLookup lookup) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Error: Could not create a socket.\n");
+        return -1;
+    }
+    unlink(socket_path); // Left behind by a previous daemon
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, 16) != 0) {
+        fprintf(stderr, "Error: Could not listen on %s.\n", socket_path);
+        close(listen_fd);
+        return -1;
+    }
+
+    // Without SA_RESTART the signals interrupt accept() so the loop ends
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // Static so the connection slots do not take up the stack
+    static DaemonServer server;
+    memset(&server, 0, sizeof(server));
+    server.lookup = lookup;
+    pthread_mutex_init(&server.lookup_lock, NULL);
+    pthread_mutex_init(&server.connections_lock, NULL);
+    if (options) {
+        server.options = *options;
+    } else {
+        default_klatt_options(&server.options);
+    }
+
+    fprintf(stderr, "Listening on %s\n", socket_path);
+    while (!daemon_stopping) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd >= 0) {
+            start_connection(&server, fd);
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            // e.g. EMFILE: retrying at once would spin until a connection ends
+            fprintf(stderr, "Error: accept() failed: %s.\n", strerror(errno));
+            struct timespec delay = {0, DAEMON_ACCEPT_BACKOFF_NS};
+            nanosleep(&delay, NULL);
+            reap_connections(&server);
+        }
+    }
+
+    stop_connections(&server);
+    pthread_mutex_destroy(&server.connections_lock);
+    pthread_mutex_destroy(&server.lookup_lock);
+    close(listen_fd);
+    unlink(socket_path);
+    fprintf(stderr, "Daemon stopped\n");
+    return 0;
+}
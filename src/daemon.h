@@ -0,0 +1,54 @@
+/* daemon.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Synthesis daemon. The process stays resident with the phoneme tables
+// loaded and serves phrase requests on a Unix domain socket, one thread
+// and one engine per connection, so a request costs no process start.
+//
+// Protocol: the client sends a phrase as one line of words ending in
+// '\n' and may send further lines on the same connection. For each line
+// the daemon answers with two little-endian 32-bit values, a status
+// (DAEMON_STATUS_*) and the sample rate. If the status is OK, blocks of
+// audio follow as they are synthesized, each a 32-bit sample count and
+// that many 16-bit little-endian samples. A count of zero ends the
+// phrase. The audio is scaled by STREAM_GAIN, as with --stream.
+// =====================================================================
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "phonemes.h"
+#include "synthesizer.h"
+
+#define DAEMON_MAX_REQUEST 1024 // Longest request line in bytes
+#define DAEMON_MAX_WORDS 64
+#define DAEMON_MAX_BLOCK_SAMPLES (MAX_SAMPLE_RATE / 4) // Largest block, a quarter second pause at the highest rate
+
+#define DAEMON_STATUS_OK 0
+#define DAEMON_STATUS_UNKNOWN_WORD 1
+#define DAEMON_STATUS_BAD_REQUEST 2  // Empty, too long or too many words
+#define DAEMON_STATUS_ERROR 3
+
+// Resolves a word to its diphones. Returns -1 if it is not known.
+typedef int (*WordLookup)(const char *word, const Diphone **diphones, int *num_diphones);
+
+int run_daemon(const char *socket_path, const KlattOptions *options, WordLookup lookup);
+
+#endif // DAEMON_H
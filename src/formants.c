@@ -0,0 +1,307 @@
+/* formants.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Implementation of the parallel formant bank
+// Define KLATT_SCALAR_FORMANTS to build the scalar reference kernel
+// only. With GCC or Clang the block kernel uses vector extensions,
+// which compile to SSE2 (or AVX with -mavx) on x86. Fixed-point builds
+// (KLATT_SAMPLE_FIXED) always use the scalar kernel.
+// =====================================================================
+#include "formants.h"
+#include "synthesizer.h"
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+// Switches off every formant and clears the filter state
+void formant_bank_reset(FormantBank *bank) {
+    memset(bank, 0, sizeof(*bank));
+}
+
+// Computes the resonator coefficients of one formant. A zero frequency
+// or bandwidth switches the formant off, like update_filter_coefficients(),
+// and so does a frequency at or above the Nyquist limit of the sample rate.
+static void compute_resonator(double frequency, double bandwidth, double dt, klatt_coef *a1, klatt_coef *a2, int *enabled) {
+    if (frequency == 0.0 || bandwidth == 0.0 || frequency * dt >= 0.5) {
+        *a1 = 0;
+        *a2 = 0;
+        *enabled = 0;
+        return;
+    }
+
+    double r = exp(-M_PI * bandwidth * dt);
+    double theta = 2 * M_PI * frequency * dt;
+    *a1 = klatt_coef_from_double(-2.0 * r * cos(theta));
+    *a2 = klatt_coef_from_double(r * r);
+    *enabled = 1;
+}
+
+// Switches one formant on or off, saving or restoring its filter state
+static void set_formant_enabled(FormantBank *bank, int formant, int enabled) {
+    if (bank->enabled[formant] && !enabled) {
+        bank->saved_y1[formant] = bank->y1[formant];
+        bank->saved_y2[formant] = bank->y2[formant];
+    } else if (!bank->enabled[formant] && enabled) {
+        bank->y1[formant] = bank->saved_y1[formant];
+        bank->y2[formant] = bank->saved_y2[formant];
+    }
+    bank->enabled[formant] = enabled;
+}
+
+// Sets the resonator coefficients of one formant
+void formant_bank_set(FormantBank *bank, int formant, double frequency, double bandwidth, double dt) {
+    int enabled;
+    compute_resonator(frequency, bandwidth, dt, &bank->a1[formant], &bank->a2[formant], &enabled);
+    set_formant_enabled(bank, formant, enabled);
+}
+
+// Sets the resonator coefficients of every formant, cancelling any ramp
+void formant_bank_load(FormantBank *bank, const FormantCoefficients *coefficients) {
+    for (int k = 0; k < NUM_FORMANTS; k++) {
+        bank->a1[k] = coefficients->a1[k];
+        bank->a2[k] = coefficients->a2[k];
+        set_formant_enabled(bank, k, coefficients->enabled[k]);
+    }
+    bank->ramp_remaining = 0;
+}
+
+// Moves the coefficients linearly from their current values to the
+// target over the next num_samples samples. A formant switching on
+// resumes from its saved state and ramps up from zero coefficients
+// (a pass-through); one switching off ramps down to a pass-through.
+void formant_bank_start_ramp(FormantBank *bank, const FormantCoefficients *target, int num_samples) {
+    if (num_samples <= 0) {
+        formant_bank_load(bank, target);
+        return;
+    }
+    for (int k = 0; k < NUM_FORMANTS; k++) {
+        if (target->enabled[k]) {
+            set_formant_enabled(bank, k, 1);
+        }
+        bank->da1[k] = (target->a1[k] - bank->a1[k]) / num_samples;
+        bank->da2[k] = (target->a2[k] - bank->a2[k]) / num_samples;
+    }
+    bank->ramp_target = *target;
+    bank->ramp_remaining = num_samples;
+}
+
+// Returns 1 if the bank already holds, or is ramping to, the coefficients
+int formant_bank_has_coefficients(const FormantBank *bank, const FormantCoefficients *coefficients) {
+    if (bank->ramp_remaining > 0) {
+        return memcmp(&bank->ramp_target, coefficients, sizeof(*coefficients)) == 0;
+    }
+    for (int k = 0; k < NUM_FORMANTS; k++) {
+        if (bank->a1[k] != coefficients->a1[k] || bank->a2[k] != coefficients->a2[k] ||
+            bank->enabled[k] != coefficients->enabled[k]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Snaps the coefficients to the ramp target once the ramp is complete
+static void finish_ramp(FormantBank *bank) {
+    for (int k = 0; k < NUM_FORMANTS; k++) {
+        bank->a1[k] = bank->ramp_target.a1[k];
+        bank->a2[k] = bank->ramp_target.a2[k];
+        set_formant_enabled(bank, k, bank->ramp_target.enabled[k]);
+    }
+}
+
+// Computes the coefficients of all formants from the phoneme parameters
+void compute_formant_coefficients(const PhonemeParams *params, double dt, FormantCoefficients *coefficients) {
+    const double frequency[NUM_FORMANTS] = {params->F1, params->F2, params->F3, params->F4, params->F5, params->F6};
+    const double bandwidth[NUM_FORMANTS] = {params->B1, params->B2, params->B3, params->B4, params->B5, params->B6};
+
+    memset(coefficients, 0, sizeof(*coefficients));
+    for (int k = 0; k < NUM_FORMANTS; k++) {
+        compute_resonator(frequency[k], bandwidth[k], dt, &coefficients->a1[k], &coefficients->a2[k], &coefficients->enabled[k]);
+    }
+}
+
+// Empties the cache and its hit and miss counters
+void coefficient_cache_clear(CoefficientCache *cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Returns the coefficients for a phoneme, computing them on a miss
+const FormantCoefficients *coefficient_cache_lookup(CoefficientCache *cache, const PhonemeParams *params, double dt) {
+    uintptr_t slot = ((uintptr_t)params / sizeof(PhonemeParams)) & (COEFFICIENT_CACHE_SIZE - 1);
+    CoefficientCacheEntry *entry = &cache->entries[slot];
+
+    // F1 to B6 are contiguous in PhonemeParams
+    if (entry->params == params && memcmp(entry->formants, &params->F1, sizeof(entry->formants)) == 0) {
+        cache->hits++;
+        return &entry->coefficients;
+    }
+
+    cache->misses++;
+    entry->params = params;
+    memcpy(entry->formants, &params->F1, sizeof(entry->formants));
+    compute_formant_coefficients(params, dt, &entry->coefficients);
+    return &entry->coefficients;
+}
+
+// Reference kernel: runs each formant through process_filter() logic
+// one sample at a time and sums the outputs
+static void process_steady_scalar(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    for (int i = 0; i < num_samples; i++) {
+        klatt_sample sum = 0;
+        for (int k = 0; k < NUM_FORMANTS; k++) {
+            klatt_sample out = input[i];
+            if (bank->enabled[k]) {
+                out = klatt_resonate(input[i], bank->a1[k], bank->a2[k], bank->y1[k], bank->y2[k]);
+                bank->y2[k] = bank->y1[k];
+                bank->y1[k] = out;
+            }
+            sum = (k == 0) ? out : sum + out;
+        }
+        output[i] = sum;
+    }
+}
+
+// Reference ramp kernel: the coefficients step towards the ramp target
+// every sample. Switched off formants have zero coefficients, so every
+// lane can be filtered.
+static void process_ramp_scalar(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    for (int i = 0; i < num_samples; i++) {
+        klatt_sample sum = 0;
+        for (int k = 0; k < NUM_FORMANTS; k++) {
+            bank->a1[k] += bank->da1[k];
+            bank->a2[k] += bank->da2[k];
+            klatt_sample out = klatt_resonate(input[i], bank->a1[k], bank->a2[k], bank->y1[k], bank->y2[k]);
+            bank->y2[k] = bank->y1[k];
+            bank->y1[k] = out;
+            sum = (k == 0) ? out : sum + out;
+        }
+        output[i] = sum;
+    }
+}
+
+typedef void (*FormantKernel)(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples);
+
+// Runs the ramp kernel for the part of the block covered by a ramp in
+// progress and the steady kernel for the rest
+static void process_block(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples,
+                          FormantKernel steady, FormantKernel ramp) {
+    int done = 0;
+    if (bank->ramp_remaining > 0) {
+        done = (num_samples < bank->ramp_remaining) ? num_samples : bank->ramp_remaining;
+        ramp(bank, input, output, done);
+        bank->ramp_remaining -= done;
+        if (bank->ramp_remaining == 0) {
+            finish_ramp(bank);
+        }
+    }
+    if (done < num_samples) {
+        steady(bank, input + done, output + done, num_samples - done);
+    }
+}
+
+void formant_bank_process_block_scalar(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    process_block(bank, input, output, num_samples, process_steady_scalar, process_ramp_scalar);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(KLATT_SCALAR_FORMANTS) && !defined(KLATT_SAMPLE_FIXED)
+
+// Width of one SIMD register in samples: 16 bytes for SSE2, 32 for AVX,
+// so two or four doubles, or four or eight floats
+#if defined(__AVX__)
+#define FORMANT_VEC_BYTES 32
+#else
+#define FORMANT_VEC_BYTES 16
+#endif
+#define FORMANT_VEC_WIDTH ((int)(FORMANT_VEC_BYTES / sizeof(klatt_sample)))
+#define FORMANT_VECS ((NUM_FORMANTS + FORMANT_VEC_WIDTH - 1) / FORMANT_VEC_WIDTH)
+
+typedef klatt_sample formant_vec __attribute__((vector_size(FORMANT_VEC_BYTES)));
+
+// Sums the formant lanes in the same order as the scalar kernels
+static inline klatt_sample sum_formants(const formant_vec *y1) {
+    klatt_sample sum = y1[0][0];
+    for (int k = 1; k < NUM_FORMANTS; k++) {
+        sum += y1[k / FORMANT_VEC_WIDTH][k % FORMANT_VEC_WIDTH];
+    }
+    return sum;
+}
+
+// SIMD kernel: all formants are updated together, one lane each.
+// Switched off formants have zero coefficients, so their lane passes
+// the input through unchanged.
+static void process_steady_simd(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    formant_vec a1[FORMANT_VECS], a2[FORMANT_VECS], y1[FORMANT_VECS], y2[FORMANT_VECS];
+    memcpy(a1, bank->a1, sizeof(a1));
+    memcpy(a2, bank->a2, sizeof(a2));
+    memcpy(y1, bank->y1, sizeof(y1));
+    memcpy(y2, bank->y2, sizeof(y2));
+
+    for (int i = 0; i < num_samples; i++) {
+        for (int v = 0; v < FORMANT_VECS; v++) {
+            formant_vec out = input[i] - a1[v] * y1[v] - a2[v] * y2[v];
+            y2[v] = y1[v];
+            y1[v] = out;
+        }
+        output[i] = sum_formants(y1);
+    }
+
+    memcpy(bank->y1, y1, sizeof(y1));
+    memcpy(bank->y2, y2, sizeof(y2));
+}
+
+// SIMD ramp kernel
+static void process_ramp_simd(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    formant_vec a1[FORMANT_VECS], a2[FORMANT_VECS], da1[FORMANT_VECS], da2[FORMANT_VECS];
+    formant_vec y1[FORMANT_VECS], y2[FORMANT_VECS];
+    memcpy(a1, bank->a1, sizeof(a1));
+    memcpy(a2, bank->a2, sizeof(a2));
+    memcpy(da1, bank->da1, sizeof(da1));
+    memcpy(da2, bank->da2, sizeof(da2));
+    memcpy(y1, bank->y1, sizeof(y1));
+    memcpy(y2, bank->y2, sizeof(y2));
+
+    for (int i = 0; i < num_samples; i++) {
+        for (int v = 0; v < FORMANT_VECS; v++) {
+            a1[v] += da1[v];
+            a2[v] += da2[v];
+            formant_vec out = input[i] - a1[v] * y1[v] - a2[v] * y2[v];
+            y2[v] = y1[v];
+            y1[v] = out;
+        }
+        output[i] = sum_formants(y1);
+    }
+
+    memcpy(bank->a1, a1, sizeof(a1));
+    memcpy(bank->a2, a2, sizeof(a2));
+    memcpy(bank->y1, y1, sizeof(y1));
+    memcpy(bank->y2, y2, sizeof(y2));
+}
+
+void formant_bank_process_block(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    process_block(bank, input, output, num_samples, process_steady_simd, process_ramp_simd);
+}
+
+#else
+
+void formant_bank_process_block(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples) {
+    formant_bank_process_block_scalar(bank, input, output, num_samples);
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* formants.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Parallel formant bank: the six formant resonators of the Klatt
+// model stored as a structure of arrays (one formant per lane) so that
+// a whole block of samples can be filtered with SIMD instructions.
+// =====================================================================
+#ifndef FORMANTS_H
+#define FORMANTS_H
+
+#include "phonemes.h"
+#include "sample.h"
+
+#define NUM_FORMANTS 6
+#define FORMANT_LANES 8 // NUM_FORMANTS padded to a whole number of SIMD registers
+#define COEFFICIENT_CACHE_SIZE 64 // Must be a power of two
+
+// Resonator coefficients of every formant for one set of phoneme parameters
+typedef struct {
+    klatt_coef a1[FORMANT_LANES];
+    klatt_coef a2[FORMANT_LANES];
+    int enabled[FORMANT_LANES];
+} FormantCoefficients;
+
+// One cached set of coefficients. The entry is found by the address of
+// the PhonemeParams and is only used if the formant frequencies and
+// bandwidths it was computed from still match.
+typedef struct {
+    const PhonemeParams *params;
+    double formants[2 * NUM_FORMANTS]; // F1, B1 ... F6, B6
+    FormantCoefficients coefficients;
+} CoefficientCacheEntry;
+
+// Direct-mapped cache of coefficients for phonemes that are held for
+// whole frames, so steady segments skip the exp() and cos() calls
+typedef struct {
+    CoefficientCacheEntry entries[COEFFICIENT_CACHE_SIZE];
+    unsigned long hits;
+    unsigned long misses;
+} CoefficientCache;
+
+typedef struct {
+    klatt_coef a1[FORMANT_LANES];
+    klatt_coef a2[FORMANT_LANES];
+    klatt_sample y1[FORMANT_LANES];
+    klatt_sample y2[FORMANT_LANES];
+    // Filter state held while a formant is switched off. A switched off
+    // formant passes its input straight through, and the SIMD kernel
+    // does that by running the lane with zero coefficients, which
+    // overwrites y1/y2. The state is restored when the formant is
+    // switched back on.
+    klatt_sample saved_y1[FORMANT_LANES];
+    klatt_sample saved_y2[FORMANT_LANES];
+    int enabled[FORMANT_LANES];
+    // Coefficient ramp in progress: a1/a2 move by da1/da2 every sample
+    // until ramp_remaining reaches zero, then snap to ramp_target.
+    klatt_coef da1[FORMANT_LANES];
+    klatt_coef da2[FORMANT_LANES];
+    FormantCoefficients ramp_target;
+    int ramp_remaining;
+} FormantBank;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+void formant_bank_reset(FormantBank *bank);
+void formant_bank_set(FormantBank *bank, int formant, double frequency, double bandwidth, double dt);
+void formant_bank_load(FormantBank *bank, const FormantCoefficients *coefficients);
+void formant_bank_start_ramp(FormantBank *bank, const FormantCoefficients *target, int num_samples);
+int formant_bank_has_coefficients(const FormantBank *bank, const FormantCoefficients *coefficients);
+void compute_formant_coefficients(const PhonemeParams *params, double dt, FormantCoefficients *coefficients);
+void coefficient_cache_clear(CoefficientCache *cache);
+const FormantCoefficients *coefficient_cache_lookup(CoefficientCache *cache, const PhonemeParams *params, double dt);
+void formant_bank_process_block_scalar(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples);
+void formant_bank_process_block(FormantBank *bank, const klatt_sample *input, klatt_sample *output, int num_samples);
+
+#endif // FORMANTS_H
@@ -0,0 +1,112 @@
+# gen_lexicon.awk
+#
+# Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# =====================================================================
+# Generates lexicon_tables.c from phonemes.c: one table entry for every
+# "const PhonemeParams PHONEME_<NAME>" and "const Diphone diphones_<word>[]"
+# definition, so new phonemes and words are picked up by a rebuild.
+# The words are also indexed by an open-addressed hash table so that
+# lexicon_find_word() resolves a word with one or two string compares.
+# The hash must match lexicon_hash_name() in lexicon.c.
+#
+#   awk -f gen_lexicon.awk phonemes.c > lexicon_tables.c
+# =====================================================================
+
+BEGIN {
+    for (i = 1; i < 256; i++) {
+        char_code[sprintf("%c", i)] = i
+    }
+}
+
+# h = h * 31 + c modulo 2^32, exact in awk's doubles
+function hash_name(name,    h, i) {
+    h = 0
+    for (i = 1; i <= length(name); i++) {
+        h = (h * 31 + char_code[substr(name, i, 1)]) % 4294967296
+    }
+    return h
+}
+
+/^const PhonemeParams PHONEME_[A-Z0-9_]+ *=/ {
+    name = $3
+    phonemes[num_phonemes++] = name
+}
+
+/^const Diphone diphones_[a-z0-9_]+\[\] *=/ {
+    name = $3
+    sub(/^diphones_/, "", name)
+    sub(/\[\]$/, "", name)
+    words[num_words++] = name
+}
+
+END {
+    print "/* lexicon_tables.c"
+    print " *"
+    print " * Generated from phonemes.c by gen_lexicon.awk. Do not edit."
+    print " */"
+    print ""
+    print "#include \"lexicon.h\""
+    print ""
+    for (i = 0; i < num_phonemes; i++) {
+        print "extern const PhonemeParams " phonemes[i] ";"
+    }
+    print ""
+    print "const LexiconPhoneme lexicon_phonemes[] = {"
+    for (i = 0; i < num_phonemes; i++) {
+        name = phonemes[i]
+        sub(/^PHONEME_/, "", name)
+        print "    {\"" name "\", &" phonemes[i] "},"
+    }
+    print "};"
+    print "const int lexicon_num_phonemes = " num_phonemes ";"
+    print ""
+    print "const LexiconWord lexicon_words[] = {"
+    for (i = 0; i < num_words; i++) {
+        print "    {\"" words[i] "\", diphones_" words[i] ", &num_diphones_" words[i] "},"
+    }
+    print "};"
+    print "const int lexicon_num_words = " num_words ";"
+    print ""
+
+    # At most half full, so probe sequences stay short
+    hash_size = 16
+    while (hash_size < 2 * num_words) {
+        hash_size *= 2
+    }
+    for (i = 0; i < hash_size; i++) {
+        slots[i] = -1
+    }
+    for (i = 0; i < num_words; i++) {
+        slot = hash_name(words[i]) % hash_size
+        while (slots[slot] != -1) {
+            slot = (slot + 1) % hash_size
+        }
+        slots[slot] = i
+    }
+    print "const int lexicon_word_hash_size = " hash_size ";"
+    print "const short lexicon_word_hash[] = {"
+    for (i = 0; i < hash_size; i += 16) {
+        line = "   "
+        for (j = i; j < i + 16 && j < hash_size; j++) {
+            line = line " " slots[j] ","
+        }
+        print line
+    }
+    print "};"
+}
@@ -0,0 +1,212 @@
+/* golden_test.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Golden output regression test. A fixed set of phrases is rendered to
+// 16-bit PCM and either written to one WAV file per phrase, or compared
+// with WAV files written earlier by the double build. The engine starts
+// from the same noise seed for every phrase, so the output is
+// deterministic. A phrase fails if its length differs, its largest
+// sample error exceeds --max-error, or its SNR is below --min-snr.
+//
+//   ./golden_double --write golden
+//   ./golden_float --compare golden --min-snr 60
+// =====================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lexicon.h"
+#include "synthesizer.h"
+
+#define GOLDEN_PATH_SIZE 512
+
+typedef struct {
+    const char *name;          // File name without .wav
+    const char *words;
+    int control_period_frames; // Coefficient ramp period, 0 for no ramp
+    int sample_rate;           // 0 for the default rate
+} GoldenCase;
+
+static const GoldenCase golden_cases[] = {
+    {"hello", "hello", 0, 0},
+    {"world", "world", 0, 0},
+    {"happy_birthday", "happy birthday", 0, 0},
+    {"monday_first_january", "monday first january", 0, 0},
+    {"thursday_thirtyfirst_may", "thursday thirtyfirst may", 0, 0},
+    {"hello_world_ramp", "hello world", 2, 0},
+    {"wednesday_8k", "wednesday", 0, 8000},
+    {"may_48k", "may", 0, 48000},
+};
+
+// Renders one case. Returns the number of samples, or -1.
+static int render_case(const GoldenCase *golden, int16_t **pcm) {
+    KlattOptions options;
+    default_klatt_options(&options);
+    if (golden->control_period_frames > 0) {
+        options.coefficient_ramp = 1;
+        options.control_period_frames = golden->control_period_frames;
+    }
+    if (golden->sample_rate > 0) {
+        options.sample_rate = golden->sample_rate;
+    }
+    KlattEngine engine;
+    if (initialize_synthesis_engine(&engine, &options) != 0) {
+        return -1;
+    }
+
+    char words[256];
+    const Diphone *word_diphones[16];
+    int num_diphones[16];
+    int num_words = 0;
+    snprintf(words, sizeof(words), "%s", golden->words);
+    for (char *word = strtok(words, " "); word != NULL && num_words < 16; word = strtok(NULL, " ")) {
+        if (lexicon_find_word(word, &word_diphones[num_words], &num_diphones[num_words]) != 0) {
+            fprintf(stderr, "Error: Unknown word '%s' in golden case %s.\n", word, golden->name);
+            free_synthesis_engine(&engine);
+            return -1;
+        }
+        num_words++;
+    }
+    int num_samples = synthesize_phrase_pcm(&engine, word_diphones, num_diphones, num_words, pcm);
+    free_synthesis_engine(&engine);
+    return num_samples;
+}
+
+// Reads the samples of a 16-bit mono WAV file written by write_wav_file().
+// Returns the number of samples, or -1.
+static int read_golden_wav(const char *path, int16_t **pcm) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open %s.\n", path);
+        return -1;
+    }
+    unsigned char header[44];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header)
+        || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0
+        || memcmp(header + 36, "data", 4) != 0 || header[34] != 16) {
+        fprintf(stderr, "Error: %s is not a 16-bit WAV file.\n", path);
+        fclose(file);
+        return -1;
+    }
+    long data_size = header[40] | (header[41] << 8) | ((long)header[42] << 16) | ((long)header[43] << 24);
+    int num_samples = (int)(data_size / 2);
+    unsigned char *bytes = (unsigned char *)malloc(data_size > 0 ? data_size : 1);
+    *pcm = (int16_t *)malloc((num_samples > 0 ? num_samples : 1) * sizeof(int16_t));
+    int ok = bytes != NULL && *pcm != NULL && fread(bytes, 1, data_size, file) == (size_t)data_size;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Error: Could not read %s.\n", path);
+        free(bytes);
+        free(*pcm);
+        return -1;
+    }
+    for (int i = 0; i < num_samples; i++) {
+        (*pcm)[i] = (int16_t)(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+    }
+    free(bytes);
+    return num_samples;
+}
+
+int main(int argc, char **argv) {
+    const char *write_dir = NULL;
+    const char *compare_dir = NULL;
+    int max_error = -1;
+    double min_snr = -INFINITY;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            write_dir = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare_dir = argv[++i];
+        } else if (strcmp(argv[i], "--max-error") == 0 && i + 1 < argc) {
+            max_error = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-snr") == 0 && i + 1 < argc) {
+            min_snr = atof(argv[++i]);
+        } else {
+            write_dir = compare_dir = NULL;
+            break;
+        }
+    }
+    if ((write_dir == NULL) == (compare_dir == NULL)) {
+        fprintf(stderr, "Usage: %s --write DIR | --compare DIR [--max-error LSB] [--min-snr DB]\n", argv[0]);
+        return 1;
+    }
+
+    int num_cases = sizeof(golden_cases) / sizeof(golden_cases[0]);
+    int num_failed = 0;
+    for (int c = 0; c < num_cases; c++) {
+        const GoldenCase *golden = &golden_cases[c];
+        char path[GOLDEN_PATH_SIZE];
+        snprintf(path, sizeof(path), "%s/%s.wav", write_dir ? write_dir : compare_dir, golden->name);
+
+        int16_t *pcm = NULL;
+        int num_samples = render_case(golden, &pcm);
+        if (num_samples < 0) {
+            return 1;
+        }
+        if (write_dir) {
+            int sample_rate = golden->sample_rate > 0 ? golden->sample_rate : SAMPLE_RATE;
+            int result = write_wav_file(path, pcm, num_samples, sample_rate);
+            free(pcm);
+            if (result != 0) {
+                return 1;
+            }
+            continue;
+        }
+
+        int16_t *reference = NULL;
+        int num_reference = read_golden_wav(path, &reference);
+        if (num_reference < 0) {
+            free(pcm);
+            return 1;
+        }
+
+        int worst = 0;
+        double signal = 0.0;
+        double noise = 0.0;
+        int length_ok = (num_reference == num_samples);
+        for (int i = 0; length_ok && i < num_samples; i++) {
+            int error = abs(pcm[i] - reference[i]);
+            if (error > worst) {
+                worst = error;
+            }
+            signal += (double)reference[i] * reference[i];
+            noise += (double)error * error;
+        }
+        double snr = (noise > 0.0) ? 10.0 * log10(signal / noise) : INFINITY;
+        int passed = length_ok && (max_error < 0 || worst <= max_error) && snr >= min_snr;
+        if (!length_ok) {
+            printf("%s: %d samples, reference has %d: FAIL\n", golden->name, num_samples, num_reference);
+        } else {
+            printf("%s: max error %d, SNR %.1f dB: %s\n", golden->name, worst, snr, passed ? "PASS" : "FAIL");
+        }
+        num_failed += !passed;
+        free(reference);
+        free(pcm);
+    }
+
+    if (write_dir) {
+        printf("%s samples: wrote %d golden files to %s\n", KLATT_SAMPLE_TYPE_NAME, num_cases, write_dir);
+        return 0;
+    }
+    printf("%s samples: %d of %d golden phrases passed\n", KLATT_SAMPLE_TYPE_NAME, num_cases - num_failed, num_cases);
+    return (num_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/* klatt.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Implementation of the public API in klatt.h on top of the engine
+// =====================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include "klatt.h"
+#include "lexicon.h"
+#include "synthesizer.h"
+
+#define KLATT_SEPARATORS " \t\r\n" // Characters between the words of a text
+
+struct KlattSynth {
+    KlattEngine engine;
+};
+
+// Diphones of the words of a text
+typedef struct {
+    const Diphone **word_diphones;
+    int *num_diphones;
+    int num_words;
+} KlattPhrase;
+
+int klatt_api_version(void) {
+    return KLATT_API_VERSION;
+}
+
+KlattSynth *klatt_create(int sample_rate) {
+    KlattOptions options;
+    default_klatt_options(&options);
+    if (sample_rate != 0) {
+        if (!sample_rate_supported(sample_rate)) {
+            return NULL;
+        }
+        options.sample_rate = sample_rate;
+    }
+
+    KlattSynth *synth = (KlattSynth *)malloc(sizeof(KlattSynth));
+    if (synth == NULL) {
+        return NULL;
+    }
+    initialize_synthesis_engine(&synth->engine, &options);
+    return synth;
+}
+
+void klatt_destroy(KlattSynth *synth) {
+    if (synth != NULL) {
+        free_synthesis_engine(&synth->engine);
+    }
+    free(synth);
+}
+
+int klatt_sample_rate(const KlattSynth *synth) {
+    return synth->engine.options.sample_rate;
+}
+
+int klatt_set_ramp(KlattSynth *synth, int control_period_frames) {
+    if (control_period_frames < 0) {
+        return KLATT_ERROR_INVALID;
+    }
+    KlattOptions options = synth->engine.options;
+    options.coefficient_ramp = (control_period_frames > 0);
+    options.control_period_frames = (control_period_frames > 0) ? control_period_frames : 1;
+    free_synthesis_engine(&synth->engine);
+    initialize_synthesis_engine(&synth->engine, &options);
+    return KLATT_OK;
+}
+
+int klatt_has_word(const char *word) {
+    const Diphone *diphones;
+    int num_diphones;
+    return lexicon_find_word(word, &diphones, &num_diphones) == 0;
+}
+
+// Looks up every word of text. Words are separated by whitespace; the
+// text is not modified, so the caller's string may be read-only. The
+// word lists are scratch memory of the engine, released by arena_reset()
+// when the request is done.
+static int parse_phrase(KlattSynth *synth, const char *text, KlattPhrase *phrase) {
+    memset(phrase, 0, sizeof(*phrase));
+    if (text == NULL) {
+        return KLATT_ERROR_INVALID;
+    }
+
+    // Count the words with the same rule as the loop below
+    int max_words = 0;
+    for (const char *p = text + strspn(text, KLATT_SEPARATORS); *p != '\0'; p += strspn(p, KLATT_SEPARATORS)) {
+        p += strcspn(p, KLATT_SEPARATORS);
+        max_words++;
+    }
+    if (max_words == 0) {
+        max_words = 1;
+    }
+    phrase->word_diphones = (const Diphone **)arena_alloc(&synth->engine.scratch, max_words * sizeof(const Diphone *));
+    phrase->num_diphones = (int *)arena_alloc(&synth->engine.scratch, max_words * sizeof(int));
+    if (phrase->word_diphones == NULL || phrase->num_diphones == NULL) {
+        arena_reset(&synth->engine.scratch);
+        return KLATT_ERROR;
+    }
+
+    const char *p = text;
+    for (;;) {
+        p += strspn(p, KLATT_SEPARATORS);
+        size_t length = strcspn(p, KLATT_SEPARATORS);
+        if (length == 0) {
+            break;
+        }
+        char word[2 * MAX_WORD_NAME];
+        int n = phrase->num_words;
+        if (length >= sizeof(word) || n >= max_words) {
+            arena_reset(&synth->engine.scratch);
+            return KLATT_ERROR_INVALID; // Not a word that could be in the lexicon
+        }
+        memcpy(word, p, length);
+        word[length] = '\0';
+        if (lexicon_find_word(word, &phrase->word_diphones[n], &phrase->num_diphones[n]) != 0) {
+            arena_reset(&synth->engine.scratch);
+            return KLATT_ERROR_UNKNOWN_WORD;
+        }
+        phrase->num_words++;
+        p += length;
+    }
+    return KLATT_OK;
+}
+
+int klatt_synthesize(KlattSynth *synth, const char *text, int16_t **samples) {
+    if (samples == NULL) {
+        return KLATT_ERROR_INVALID;
+    }
+    KlattPhrase phrase;
+    int result = parse_phrase(synth, text, &phrase);
+    if (result != KLATT_OK) {
+        return result;
+    }
+    int num_samples = synthesize_phrase_pcm(&synth->engine, phrase.word_diphones, phrase.num_diphones, phrase.num_words, samples);
+    arena_reset(&synth->engine.scratch);
+    return (num_samples < 0) ? KLATT_ERROR : num_samples;
+}
+
+void klatt_free_samples(int16_t *samples) {
+    free(samples);
+}
+
+// Passes blocks on to the caller's callback and notes if it stopped
+typedef struct {
+    KlattPcmCallback callback;
+    void *user_data;
+    int stopped;
+} KlattStream;
+
+static int stream_sink(void *user_data, const int16_t *samples, int num_samples) {
+    KlattStream *stream = (KlattStream *)user_data;
+    if (stream->callback(stream->user_data, samples, num_samples) != 0) {
+        stream->stopped = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int klatt_synthesize_stream(KlattSynth *synth, const char *text, KlattPcmCallback callback, void *user_data) {
+    if (callback == NULL) {
+        return KLATT_ERROR_INVALID;
+    }
+    KlattPhrase phrase;
+    int result = parse_phrase(synth, text, &phrase);
+    if (result != KLATT_OK) {
+        return result;
+    }
+    KlattStream stream = {callback, user_data, 0};
+    int num_samples = synthesize_phrase_streaming(&synth->engine, phrase.word_diphones, phrase.num_diphones, phrase.num_words,
+                                                  STREAM_GAIN, stream_sink, &stream);
+    arena_reset(&synth->engine.scratch);
+    if (num_samples < 0) {
+        return stream.stopped ? KLATT_ERROR_STOPPED : KLATT_ERROR;
+    }
+    return num_samples;
+}
@@ -0,0 +1,99 @@
+/* klatt.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Public C API of libklatt (make lib). This is the only header a program
+// embedding the synthesizer needs; the engine structures stay private,
+// so they can change without breaking programs built against this API.
+//
+//   KlattSynth *synth = klatt_create(0);
+//   int16_t *samples;
+//   int n = klatt_synthesize(synth, "monday first january", &samples);
+//   ...
+//   klatt_free_samples(samples);
+//   klatt_destroy(synth);
+//
+// A KlattSynth must only be used by one thread at a time. Separate
+// KlattSynth objects can be used from separate threads.
+// =====================================================================
+#ifndef KLATT_H
+#define KLATT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KLATT_API __attribute__((visibility("default")))
+#else
+#define KLATT_API
+#endif
+
+#define KLATT_API_VERSION 1
+
+// Return codes. Functions returning a sample count return one of these
+// (all negative) on failure.
+#define KLATT_OK 0
+#define KLATT_ERROR -1              // Out of memory or an I/O error
+#define KLATT_ERROR_INVALID -2      // Invalid argument, e.g. an unsupported sample rate
+#define KLATT_ERROR_UNKNOWN_WORD -3 // A word of the text is not in the lexicon
+#define KLATT_ERROR_STOPPED -4      // The callback asked to stop
+
+typedef struct KlattSynth KlattSynth;
+
+// Receives blocks of 16-bit mono samples. Return 0 to continue or
+// nonzero to stop synthesis.
+typedef int (*KlattPcmCallback)(void *user_data, const int16_t *samples, int num_samples);
+
+KLATT_API int klatt_api_version(void);
+
+// Creates a synthesizer rendering at sample_rate Hz (0 for the default
+// of 16000). Returns NULL if the rate is not supported or memory runs out.
+KLATT_API KlattSynth *klatt_create(int sample_rate);
+KLATT_API void klatt_destroy(KlattSynth *synth);
+KLATT_API int klatt_sample_rate(const KlattSynth *synth);
+
+// Ramps formant coefficients per sample, updating them every
+// control_period_frames 10 ms frames; 0 switches ramping off.
+KLATT_API int klatt_set_ramp(KlattSynth *synth, int control_period_frames);
+
+// Returns 1 if the word is in the lexicon
+KLATT_API int klatt_has_word(const char *word);
+
+// Speaks text, a list of lexicon words separated by spaces, tabs or line
+// breaks. The samples are peak normalized. Returns the number of samples
+// and sets *samples to a buffer to release with klatt_free_samples(), or
+// returns an error code: KLATT_ERROR_UNKNOWN_WORD for a word that is not
+// in the lexicon, KLATT_ERROR_INVALID for one too long to be a word.
+KLATT_API int klatt_synthesize(KlattSynth *synth, const char *text, int16_t **samples);
+KLATT_API void klatt_free_samples(int16_t *samples);
+
+// Speaks text and passes every 10 ms block to callback as soon as it is
+// rendered. The blocks are scaled by a fixed gain instead of being peak
+// normalized. Returns the number of samples or an error code.
+KLATT_API int klatt_synthesize_stream(KlattSynth *synth, const char *text, KlattPcmCallback callback, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // KLATT_H
@@ -0,0 +1,203 @@
+/* klatt_client.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Client for the synthesis daemon. Sends one phrase to a running
+// "synthesizer --daemon SOCKET" and writes the audio it streams back as
+// raw 16-bit PCM to stdout, or to a WAV file with --wav. See daemon.h
+// for the protocol.
+// =====================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "daemon.h"
+
+#define CLIENT_MAX_SAMPLES (INT32_MAX / 2) // Keeps the byte size within int range
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Reads exactly size bytes. Returns -1 if the daemon closes first.
+static int recv_all(int fd, uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return -1;
+        }
+        data += received;
+        size -= received;
+    }
+    return 0;
+}
+
+static int connect_to_daemon(const char *socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Error: Could not connect to %s.\n", socket_path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// Sends text and reads the reply into a growing sample buffer. Returns
+// the number of samples, or -1 on error.
+static int request_phrase(int fd, const char *text, int16_t **pcm, int *sample_rate) {
+    char request[DAEMON_MAX_REQUEST];
+    int length = snprintf(request, sizeof(request), "%s\n", text);
+    if (length >= (int)sizeof(request) || strchr(text, '\n') != NULL) {
+        fprintf(stderr, "Error: Text must be one line of at most %d bytes.\n", DAEMON_MAX_REQUEST - 2);
+        return -1;
+    }
+    for (int sent = 0; sent < length; ) {
+        ssize_t n = send(fd, request + sent, length - sent, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Error: Could not send the request.\n");
+            return -1;
+        }
+        sent += n;
+    }
+
+    uint8_t header[8];
+    if (recv_all(fd, header, sizeof(header)) != 0) {
+        fprintf(stderr, "Error: The daemon closed the connection.\n");
+        return -1;
+    }
+    int status = (int)get_le32(header);
+    *sample_rate = (int)get_le32(header + 4);
+    if (status == DAEMON_STATUS_UNKNOWN_WORD) {
+        fprintf(stderr, "Error: The daemon does not know a word in \"%s\".\n", text);
+        return -1;
+    } else if (status != DAEMON_STATUS_OK) {
+        fprintf(stderr, "Error: The daemon rejected the request (status %d).\n", status);
+        return -1;
+    }
+
+    int16_t *samples = NULL;
+    int num_samples = 0;
+    int capacity = 0;
+    for (;;) {
+        uint8_t count[4];
+        if (recv_all(fd, count, sizeof(count)) != 0) {
+            fprintf(stderr, "Error: The daemon closed the connection.\n");
+            free(samples);
+            return -1;
+        }
+        uint32_t block_samples = get_le32(count);
+        if (block_samples == 0) {
+            break;
+        }
+        if (block_samples > DAEMON_MAX_BLOCK_SAMPLES || (int)block_samples > CLIENT_MAX_SAMPLES - num_samples) {
+            fprintf(stderr, "Error: The daemon sent an invalid block of %u samples.\n", (unsigned)block_samples);
+            free(samples);
+            return -1;
+        }
+        int n = (int)block_samples;
+        if (num_samples + n > capacity) {
+            int new_capacity = capacity ? capacity : 16384;
+            while (new_capacity < num_samples + n) {
+                new_capacity = (new_capacity > CLIENT_MAX_SAMPLES / 2) ? CLIENT_MAX_SAMPLES : new_capacity * 2;
+            }
+            int16_t *grown = (int16_t *)realloc(samples, (size_t)new_capacity * sizeof(int16_t));
+            if (grown == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed.\n");
+                free(samples);
+                return -1;
+            }
+            samples = grown;
+            capacity = new_capacity;
+        }
+        uint8_t *bytes = (uint8_t *)(samples + num_samples);
+        if (recv_all(fd, bytes, 2 * (size_t)n) != 0) {
+            fprintf(stderr, "Error: The daemon closed the connection.\n");
+            free(samples);
+            return -1;
+        }
+        for (int i = 0; i < n; i++) {
+            samples[num_samples + i] = (int16_t)(bytes[2 * i] | (bytes[2 * i + 1] << 8));
+        }
+        num_samples += n;
+    }
+    *pcm = samples;
+    return num_samples;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s SOCKET TEXT [--wav FILE]\n", program);
+    fprintf(stderr, "Speak TEXT with the daemon on SOCKET (synthesizer --daemon SOCKET). The\n");
+    fprintf(stderr, "audio goes to stdout as raw 16-bit PCM, or to FILE with --wav.\n");
+}
+
+int main(int argc, char **argv) {
+    const char *wav_file = NULL;
+    if (argc == 5 && strcmp(argv[3], "--wav") == 0) {
+        wav_file = argv[4];
+    } else if (argc != 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int fd = connect_to_daemon(argv[1]);
+    if (fd < 0) {
+        return 1;
+    }
+    int16_t *pcm = NULL;
+    int sample_rate = 0;
+    int num_samples = request_phrase(fd, argv[2], &pcm, &sample_rate);
+    close(fd);
+    if (num_samples < 0) {
+        return 1;
+    }
+
+    int result = 0;
+    if (wav_file != NULL) {
+        result = write_wav_file(wav_file, pcm, num_samples, sample_rate);
+    } else if (fwrite(pcm, sizeof(int16_t), num_samples, stdout) != (size_t)num_samples) {
+        fprintf(stderr, "Error: Could not write the audio to stdout.\n");
+        result = -1;
+    }
+    free(pcm);
+    return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+/* lexicon.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <ctype.h>
+#include <string.h>
+#include "lexicon.h"
+
+int lexicon_normalize_word(const char *word, char *normalized, size_t size) {
+    size_t len = 0;
+    for (const char *c = word; *c != '\0'; c++) {
+        if (!isalnum((unsigned char)*c)) {
+            continue; // drop hyphens and punctuation
+        }
+        if (len + 1 >= size) {
+            return -1;
+        }
+        normalized[len++] = (char)tolower((unsigned char)*c);
+    }
+    if (len == 0) {
+        return -1;
+    }
+    normalized[len] = '\0';
+    return 0;
+}
+
+uint32_t lexicon_hash_name(const char *name) {
+    uint32_t h = 0;
+    for (const char *c = name; *c != '\0'; c++) {
+        h = h * 31 + (unsigned char)*c;
+    }
+    return h;
+}
+
+int lexicon_find_word(const char *word, const Diphone **diphones, int *num_diphones) {
+    char name[MAX_WORD_NAME];
+    if (lexicon_normalize_word(word, name, sizeof(name)) != 0) {
+        return -1;
+    }
+    uint32_t mask = (uint32_t)lexicon_word_hash_size - 1;
+    for (uint32_t slot = lexicon_hash_name(name) & mask; lexicon_word_hash[slot] >= 0; slot = (slot + 1) & mask) {
+        const LexiconWord *entry = &lexicon_words[lexicon_word_hash[slot]];
+        if (strcmp(entry->name, name) == 0) {
+            *diphones = entry->diphones;
+            *num_diphones = *entry->num_diphones;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int lexicon_phoneme_index(const PhonemeParams *params) {
+    for (int i = 0; i < lexicon_num_phonemes; i++) {
+        if (lexicon_phonemes[i].params == params) {
+            return i;
+        }
+    }
+    return -1;
+}
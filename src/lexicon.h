@@ -0,0 +1,74 @@
+/* lexicon.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Index of the phonemes and words defined in phonemes.c. The tables
+// live in lexicon_tables.c, which the build generates from phonemes.c
+// with gen_lexicon.awk.
+// =====================================================================
+#ifndef LEXICON_H
+#define LEXICON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "phonemes.h"
+
+#define MAX_WORD_NAME 32
+
+typedef struct {
+    const char *name; // e.g. "AH" for PHONEME_AH
+    const PhonemeParams *params;
+} LexiconPhoneme;
+
+typedef struct {
+    const char *name; // e.g. "twentyfirst" for diphones_twentyfirst
+    const Diphone *diphones;
+    const int *num_diphones;
+} LexiconWord;
+
+extern const LexiconPhoneme lexicon_phonemes[];
+extern const int lexicon_num_phonemes;
+extern const LexiconWord lexicon_words[];
+extern const int lexicon_num_words;
+// Open-addressed hash index of lexicon_words: each slot holds a word
+// index or -1. The size is a power of two.
+extern const short lexicon_word_hash[];
+extern const int lexicon_word_hash_size;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+
+// Reduces a word as typed (e.g. "Twenty-First") to the form used for
+// lexicon names ("twentyfirst"). Returns -1 if the word is empty or does
+// not fit in size bytes.
+int lexicon_normalize_word(const char *word, char *normalized, size_t size);
+
+// Hash of a normalized word name, shared with gen_lexicon.awk
+uint32_t lexicon_hash_name(const char *name);
+
+// Resolves a word as typed (e.g. "Twenty-first") to its diphone
+// sequence. Returns -1 if the word is not in the lexicon.
+int lexicon_find_word(const char *word, const Diphone **diphones, int *num_diphones);
+
+// Returns the index of params in lexicon_phonemes, or -1
+int lexicon_phoneme_index(const PhonemeParams *params);
+
+#endif // LEXICON_H
@@ -18,212 +18,661 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
 #include <time.h>
+#include <signal.h>
+#include <sys/stat.h>
 #include "phonemes.h"
 #include "synthesizer.h"
+#include "batch.h"
+#include "lexicon.h"
+#include "voicebank.h"
+#include "resampler.h"
+#include "daemon.h"
+#include "playback.h"
+#include "arpabet.h"
+
 
+// Settings gathered from the command line
+typedef struct {
+    int stream;
+    const char *batch_file;
+    int all_dates;
+    const char *out_dir;
+    int num_threads;
+    const char *voicebank_file;
+    const char *say_text;
+    const char *phoneme_text; // Phoneme symbols to speak instead of lexicon words
+    int cache_mb;
+    int segments;
+    int output_rate;  // Rate delivered after resampling, 0 for the engine rate
+    int ulaw;         // Deliver 8-bit mu-law instead of 16-bit PCM
+    const char *stats_file; // Instrumentation counters are written here as JSON, - for stderr
+    const char *daemon_socket; // Serve requests on this Unix socket
+    int play;               // Play in-process through aplay instead of writing a WAV first
+    const char *play_file;  // Play in-process into this file or FIFO
+    KlattOptions options;
+} CommandLine;
 
 // Function prototypes
-void synthesize_word_and_save(const char* word_name, const Diphone* diphones, int num_diphones);
-void synthesize_phrase_and_save(const char* filename, const Diphone** word_diphones, int* num_diphones, int num_words);
+int lookup_word(const char *word, const Diphone **diphones, int *num_diphones);
+int open_voice_bank(const char *path);
+void close_voice_bank(void);
+int lookup_bank_word(const char *word, const Diphone **diphones, int *num_diphones);
+int load_batch_file(const char *path, const char *out_dir, BatchPhrase **phrases);
+int make_all_date_phrases(const char *out_dir, BatchPhrase **phrases);
+int parse_command_line(int argc, char **argv, CommandLine *cmd);
+int run_batch_mode(const CommandLine *cmd);
+int write_stats(const CommandLine *cmd, const KlattStats *stats);
+int deliver_phrase(const CommandLine *cmd, KlattEngine *engine, const char *filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words);
+int stream_phrase(const CommandLine *cmd, KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, PcmSink sink, void *user_data);
+int play_phrase(const CommandLine *cmd, KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, FILE *log);
 
 // Dictionaries for date components
 const char* weekdays[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
 const char* months[] = {"january", "february", "march", "april", "may", "june", "july", "august", "september", "october", "november", "december"};
 const char* ordinal_digits[] = {"first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth", "ninth", "tenth", "eleventh", "twelfth", "thirteenth", "fourteenth", "fifteenth", "sixteenth", "seventeenth", "eighteenth", "nineteenth", "twentieth", "twenty-first", "twenty-second", "twenty-third", "twenty-fourth", "twenty-fifth", "twenty-sixth", "twenty-seventh", "twenty-eighth", "twenty-ninth", "thirtieth", "thirty-first"};
 
-int main(void) {
+#define NUM_WEEKDAYS 7
+#define NUM_MONTHS 12
+#define NUM_ORDINALS 31
+
+// Voice bank given with --voicebank. Its words are turned into Diphone
+// arrays the first time they are used.
+static VoiceBank voice_bank;
+static int have_voice_bank = 0;
+static Diphone **voice_bank_words = NULL;
+
+int main(int argc, char **argv) {
     
-    printf("Date reader speech synthesizer up and running ...\n");
+    CommandLine cmd;
+    if (parse_command_line(argc, argv, &cmd) != 0) {
+        return 1;
+    }
+    if (cmd.voicebank_file != NULL && open_voice_bank(cmd.voicebank_file) != 0) {
+        return 1;
+    }
+    if (cmd.batch_file != NULL || cmd.all_dates) {
+        int result = run_batch_mode(&cmd);
+        close_voice_bank();
+        return result;
+    }
+    if (cmd.daemon_socket != NULL) {
+        int result = run_daemon(cmd.daemon_socket, &cmd.options, lookup_word);
+        close_voice_bank();
+        return result == 0 ? 0 : 1;
+    }
+    int stream = cmd.stream;
+
+    // When streaming, stdout carries the audio so messages go to stderr
+    FILE *log = stream ? stderr : stdout;
+
+    fprintf(log, "Date reader speech synthesizer up and running ...\n");
     // Reset the synthesis engine state once at the beginning
-    reset_synthesis_engine_state();
+    KlattEngine engine;
+    initialize_synthesis_engine(&engine, &cmd.options);
     //say hello
     
-     // Get the current day of the week and day of the month
-    time_t t = time(NULL);
-    struct tm tm = *localtime(&t);
-    int current_day_of_week = tm.tm_wday; // 0 = Sunday, 1 = Monday, etc.
-    int current_day_of_month = tm.tm_mday;//current day of the month (1-31)
-    int current_month_index = tm.tm_mon; //month (0=Jan, 7=Aug)
-    int current_year = tm.tm_year+1900;
-    printf("date: %d-%d-%d\n",current_day_of_month,current_month_index+1,current_year);
-    
-    const char* weekday =weekdays[tm.tm_wday];
-    const char* ordinal_day =ordinal_digits[tm.tm_mday - 1]; // Array is 0-indexed
-    const char* month = months[tm.tm_mon];
-    
-    printf("speech synthesizer saying: %s %s %s\n",weekday,ordinal_day,month);
-    
-    const Diphone* date_phrase_diphones[3];
-    int num_diphones_in_date_phrase[3];
-    
-    // Select the correct day of the week
-    switch (current_day_of_week) {
-        case 0: date_phrase_diphones[0] = diphones_sunday; num_diphones_in_date_phrase[0] = num_diphones_sunday; break;
-        case 1: date_phrase_diphones[0] = diphones_monday; num_diphones_in_date_phrase[0] = num_diphones_monday; break;
-        case 2: date_phrase_diphones[0] = diphones_tuesday; num_diphones_in_date_phrase[0] = num_diphones_tuesday; break;
-        case 3: date_phrase_diphones[0] = diphones_wednesday; num_diphones_in_date_phrase[0] = num_diphones_wednesday; break;
-        case 4: date_phrase_diphones[0] = diphones_thursday; num_diphones_in_date_phrase[0] = num_diphones_thursday; break;
-        case 5: date_phrase_diphones[0] = diphones_friday; num_diphones_in_date_phrase[0] = num_diphones_friday; break;
-        case 6: date_phrase_diphones[0] = diphones_saturday; num_diphones_in_date_phrase[0] = num_diphones_saturday; break;
-        default:
-            fprintf(stderr, "Error: Invalid day of week.\n");
-            return 1;
+    const char* phrase_words[MAX_PHRASE_WORDS];
+    int num_phrase_words = 0;
+    const char *wav_file = "date.wav";
+    char say_text[1024];
+
+    if (cmd.say_text != NULL) {
+        // Speak the words given on the command line, e.g. --say "hello world"
+        snprintf(say_text, sizeof(say_text), "%s", cmd.say_text);
+        for (char *token = strtok(say_text, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n")) {
+            if (num_phrase_words >= MAX_PHRASE_WORDS) {
+                fprintf(stderr, "Error: Phrase has more than %d words.\n", MAX_PHRASE_WORDS);
+                return 1;
+            }
+            phrase_words[num_phrase_words++] = token;
+        }
+        wav_file = "say.wav";
+        fprintf(log, "speech synthesizer saying: %s\n", cmd.say_text);
+    } else if (cmd.phoneme_text != NULL) {
+        wav_file = "say.wav";
+        fprintf(log, "speech synthesizer saying: /%s/\n", cmd.phoneme_text);
+    } else {
+         // Get the current day of the week and day of the month
+        time_t t = time(NULL);
+        struct tm tm = *localtime(&t);
+        int current_day_of_month = tm.tm_mday;//current day of the month (1-31)
+        int current_month_index = tm.tm_mon; //month (0=Jan, 7=Aug)
+        int current_year = tm.tm_year+1900;
+        fprintf(log, "date: %d-%d-%d\n",current_day_of_month,current_month_index+1,current_year);
+
+        phrase_words[0] = weekdays[tm.tm_wday];
+        phrase_words[1] = ordinal_digits[tm.tm_mday - 1]; // Array is 0-indexed
+        phrase_words[2] = months[tm.tm_mon];
+        num_phrase_words = 3; //e.g. monday second february
+
+        fprintf(log, "speech synthesizer saying: %s %s %s\n",phrase_words[0],phrase_words[1],phrase_words[2]);
     }
 
-    //Select the correct day of the month
-    switch (current_day_of_month) {
-		case 1: date_phrase_diphones[1] = diphones_first; num_diphones_in_date_phrase[1] = num_diphones_first; break;
-		case 2: date_phrase_diphones[1] = diphones_second; num_diphones_in_date_phrase[1] = num_diphones_second; break;
-		case 3: date_phrase_diphones[1] = diphones_third; num_diphones_in_date_phrase[1] = num_diphones_third; break;
-        case 4: date_phrase_diphones[1] = diphones_fourth; num_diphones_in_date_phrase[1] = num_diphones_fourth; break;
-        case 5: date_phrase_diphones[1] = diphones_fifth; num_diphones_in_date_phrase[1] = num_diphones_fifth; break;
-        case 6: date_phrase_diphones[1] = diphones_sixth; num_diphones_in_date_phrase[1] = num_diphones_sixth; break;
-        case 7: date_phrase_diphones[1] = diphones_seventh; num_diphones_in_date_phrase[1] = num_diphones_seventh; break;
-        case 8: date_phrase_diphones[1] = diphones_eighth; num_diphones_in_date_phrase[1] = num_diphones_eighth; break;
-        case 9: date_phrase_diphones[1] = diphones_ninth; num_diphones_in_date_phrase[1] = num_diphones_ninth; break;
-        case 10: date_phrase_diphones[1] = diphones_tenth; num_diphones_in_date_phrase[1] = num_diphones_tenth; break;
-        case 11: date_phrase_diphones[1] = diphones_eleventh; num_diphones_in_date_phrase[1] = num_diphones_eleventh; break;
-        case 12: date_phrase_diphones[1] = diphones_twelfth; num_diphones_in_date_phrase[1] = num_diphones_twelfth; break;
-        case 13: date_phrase_diphones[1] = diphones_thirteenth; num_diphones_in_date_phrase[1] = num_diphones_thirteenth; break;       
-        case 14: date_phrase_diphones[1] = diphones_fourteenth; num_diphones_in_date_phrase[1] = num_diphones_fourteenth; break;
-        case 15: date_phrase_diphones[1] = diphones_fifteenth; num_diphones_in_date_phrase[1] = num_diphones_fifteenth; break;
-        case 16: date_phrase_diphones[1] = diphones_sixteenth; num_diphones_in_date_phrase[1] = num_diphones_sixteenth; break;
-        case 17: date_phrase_diphones[1] = diphones_seventeenth; num_diphones_in_date_phrase[1] = num_diphones_seventeenth; break;
-        case 18: date_phrase_diphones[1] = diphones_eighteenth; num_diphones_in_date_phrase[1] = num_diphones_eighteenth; break;
-        case 19: date_phrase_diphones[1] = diphones_nineteenth; num_diphones_in_date_phrase[1] = num_diphones_nineteenth; break;
-        case 20: date_phrase_diphones[1] = diphones_twentieth; num_diphones_in_date_phrase[1] = num_diphones_twentieth; break;
-        case 21: date_phrase_diphones[1] = diphones_twentyfirst; num_diphones_in_date_phrase[1] = num_diphones_twentyfirst; break;
-        case 22: date_phrase_diphones[1] = diphones_twentysecond; num_diphones_in_date_phrase[1] = num_diphones_twentysecond; break;
-        case 23: date_phrase_diphones[1] = diphones_twentythird; num_diphones_in_date_phrase[1] = num_diphones_twentythird; break;
-        case 24: date_phrase_diphones[1] = diphones_twentyfourth; num_diphones_in_date_phrase[1] = num_diphones_twentyfourth; break;
-        case 25: date_phrase_diphones[1] = diphones_twentyfifth; num_diphones_in_date_phrase[1] = num_diphones_twentyfifth; break;
-        case 26: date_phrase_diphones[1] = diphones_twentysixth; num_diphones_in_date_phrase[1] = num_diphones_twentysixth; break;
-        case 27: date_phrase_diphones[1] = diphones_twentyseventh; num_diphones_in_date_phrase[1] = num_diphones_twentyseventh; break;
-        case 28: date_phrase_diphones[1] = diphones_twentyeighth; num_diphones_in_date_phrase[1] = num_diphones_twentyeighth; break;
-        case 29: date_phrase_diphones[1] = diphones_twentyninth; num_diphones_in_date_phrase[1] = num_diphones_twentyninth; break;
-        case 30: date_phrase_diphones[1] = diphones_thirtieth; num_diphones_in_date_phrase[1] = num_diphones_thirtieth; break;
-        case 31: date_phrase_diphones[1] = diphones_thirtyfirst; num_diphones_in_date_phrase[1] = num_diphones_thirtyfirst; break;        
-        default:
-            fprintf(stderr, "Error: Invalid day of month.\n");
+    const Diphone* phrase_diphones[MAX_PHRASE_WORDS];
+    int num_diphones_in_phrase[MAX_PHRASE_WORDS];
+    for (int i = 0; i < num_phrase_words; i++) {
+        if (lookup_word(phrase_words[i], &phrase_diphones[i], &num_diphones_in_phrase[i]) != 0) {
+            fprintf(stderr, "Error: Unknown word '%s'.\n", phrase_words[i]);
+            free_synthesis_engine(&engine);
+            close_voice_bank();
             return 1;
+        }
     }
-    
-    switch (current_month_index) {
-        case 0: date_phrase_diphones[2] = diphones_january; num_diphones_in_date_phrase[2] = num_diphones_january; break;
-        case 1: date_phrase_diphones[2] = diphones_february; num_diphones_in_date_phrase[2] = num_diphones_february; break;
-        case 2: date_phrase_diphones[2] = diphones_march; num_diphones_in_date_phrase[2] = num_diphones_march; break;
-        case 3: date_phrase_diphones[2] = diphones_april; num_diphones_in_date_phrase[2] = num_diphones_april; break;
-        case 4: date_phrase_diphones[2] = diphones_may; num_diphones_in_date_phrase[2] = num_diphones_may; break;
-        case 5: date_phrase_diphones[2] = diphones_june; num_diphones_in_date_phrase[2] = num_diphones_june; break;
-        case 6: date_phrase_diphones[2] = diphones_july; num_diphones_in_date_phrase[2] = num_diphones_july; break;
-        case 7: date_phrase_diphones[2] = diphones_august; num_diphones_in_date_phrase[2] = num_diphones_august; break;
-        case 8: date_phrase_diphones[2] = diphones_september; num_diphones_in_date_phrase[2] = num_diphones_september; break;
-        case 9: date_phrase_diphones[2] = diphones_october; num_diphones_in_date_phrase[2] = num_diphones_october; break;
-        case 10: date_phrase_diphones[2] = diphones_november; num_diphones_in_date_phrase[2] = num_diphones_november; break;
-        case 11: date_phrase_diphones[2] = diphones_december; num_diphones_in_date_phrase[2] = num_diphones_december; break; 
-        default:
-            fprintf(stderr, "Error: Invalid day of week.\n");
+    if (cmd.phoneme_text != NULL) {
+        // Words spelled out in phonemes, e.g. --phonemes "HH EH L OW SIL, W ER L D SIL".
+        // The diphones live in the engine's scratch arena for this utterance.
+        num_phrase_words = arpabet_phrase_diphones(cmd.phoneme_text, &engine.scratch, phrase_diphones, num_diphones_in_phrase, MAX_PHRASE_WORDS);
+        if (num_phrase_words < 0) {
+            free_synthesis_engine(&engine);
+            close_voice_bank();
             return 1;
-    }   
+        }
+    }
 
-    
-    int num_phrase_words=3; //e.g. monday second february
-    
-    synthesize_phrase_and_save("date.wav", date_phrase_diphones, num_diphones_in_date_phrase, num_phrase_words);
+    if (stream) {
+        // Raw mono samples at the output rate, e.g. ./synthesizer --stream | aplay -r 16000 -c 1 -f S16_LE
+        int result = stream_phrase(&cmd, &engine, phrase_diphones, num_diphones_in_phrase, num_phrase_words,
+                                   cmd.ulaw ? pcm_sink_ulaw_file : pcm_sink_file, stdout);
+        KlattStats stats;
+        synthesis_engine_stats(&engine, &stats);
+        write_stats(&cmd, &stats);
+        free_synthesis_engine(&engine);
+        close_voice_bank();
+        return (result < 0) ? 1 : 0;
+    }
+
+    if (cmd.play || cmd.play_file != NULL) {
+        int result = play_phrase(&cmd, &engine, phrase_diphones, num_diphones_in_phrase, num_phrase_words, log);
+        KlattStats stats;
+        synthesis_engine_stats(&engine, &stats);
+        write_stats(&cmd, &stats);
+        free_synthesis_engine(&engine);
+        close_voice_bank();
+        return (result < 0) ? 1 : 0;
+    }
+
+    printf("synthesizing phrase and saving...\n");
+    int result = deliver_phrase(&cmd, &engine, wav_file, phrase_diphones, num_diphones_in_phrase, num_phrase_words);
+    KlattStats stats;
+    synthesis_engine_stats(&engine, &stats);
+    write_stats(&cmd, &stats);
+    if (result < 0) {
+        free_synthesis_engine(&engine);
+        close_voice_bank();
+        return 1;
+    }
+    printf("Synthesis of phrase complete. Writing to %s.\n", wav_file);
         
-    char* aplay_str ="aplay -r 10000 -c 1 -f S16_LE date.wav"; 
+    char aplay_str[80];
+    snprintf(aplay_str, sizeof(aplay_str), "aplay -r %d -c 1 -f %s %s",
+             cmd.output_rate ? cmd.output_rate : engine.options.sample_rate, cmd.ulaw ? "MU_LAW" : "S16_LE", wav_file);
     system(aplay_str); 
    
+    free_synthesis_engine(&engine);
+    close_voice_bank();
 
     return 0;
 }
 
 // =====================================================================
-// Helper function to synthesize a single word and save it to a file
+// Output
 // =====================================================================
-void synthesize_word_and_save(const char* word_name, const Diphone* diphones, int num_diphones) {
-    int total_duration_samples = 0;
-    for (int i = 0; i < num_diphones; i++) {
-        total_duration_samples += (diphones[i].start_frames + diphones[i].transition_frames + diphones[i].end_frames) * (int)(SAMPLE_RATE * FRAME_PERIOD_S);
+// Synthesizes a phrase and writes it to filename at the --output-rate,
+// as 16-bit PCM or --ulaw. The phrase is rendered once at the engine
+// rate and resampled afterwards. Returns -1 on error.
+int deliver_phrase(const CommandLine *cmd, KlattEngine *engine, const char *filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words) {
+    int engine_rate = engine->options.sample_rate;
+    int output_rate = cmd->output_rate ? cmd->output_rate : engine_rate;
+    if (output_rate == engine_rate && !cmd->ulaw) {
+        return (synthesize_phrase_and_save(engine, filename, word_diphones, num_diphones, num_words) < 0) ? -1 : 0;
     }
 
-    // Allocate buffer for the entire word
-    double* audio_buffer = (double*)calloc(total_duration_samples, sizeof(double));
-    if (!audio_buffer) {
-        fprintf(stderr, "Error: Could not allocate audio buffer.\n");
-        return;
+    // The engine-rate samples are scratch memory of the engine
+    ArenaMark mark = arena_mark(&engine->scratch);
+    int16_t *pcm = NULL;
+    int16_t *resampled = NULL;
+    int num_samples = synthesize_phrase_pcm_scratch(engine, word_diphones, num_diphones, num_words, &pcm);
+    if (num_samples >= 0 && output_rate != engine_rate) {
+        num_samples = resample_pcm(pcm, num_samples, engine_rate, output_rate, &resampled);
+        pcm = resampled;
     }
 
-    // Synthesize the diphones into the buffer
-    int current_sample = 0;
-    for (int i = 0; i < num_diphones; i++) {
-        synthesize_diphone(&diphones[i], audio_buffer, &current_sample);
+    int result = -1;
+    if (num_samples >= 0) {
+        result = cmd->ulaw ? write_ulaw_wav_file(filename, pcm, num_samples, output_rate)
+                           : write_wav_file(filename, pcm, num_samples, output_rate);
     }
-    
-    // Normalize and write the buffer to a WAV file
-    normalize_and_write_to_file(word_name, audio_buffer, total_duration_samples, SAMPLE_RATE);
+    free(resampled);
+    arena_rewind(&engine->scratch, mark);
+    return result;
+}
+
+// Streams a phrase to sink at the --output-rate. Returns -1 on error.
+int stream_phrase(const CommandLine *cmd, KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, PcmSink sink, void *user_data) {
+    int engine_rate = engine->options.sample_rate;
+    if (cmd->output_rate == 0 || cmd->output_rate == engine_rate) {
+        return synthesize_phrase_streaming(engine, word_diphones, num_diphones, num_words, STREAM_GAIN, sink, user_data);
+    }
+
+    ResamplerSink resampler;
+    if (resampler_sink_init(&resampler, engine_rate, cmd->output_rate, sink, user_data) != 0) {
+        return -1;
+    }
+    int result = synthesize_phrase_streaming(engine, word_diphones, num_diphones, num_words, STREAM_GAIN, resampler_sink, &resampler);
+    if (result >= 0 && resampler_sink_finish(&resampler) != 0) {
+        result = -1;
+    }
+    resampler_sink_free(&resampler);
+    return result;
+}
+
+// Plays a phrase while it is synthesized: this thread renders into a
+// ring buffer and an output thread writes it to aplay or the --play-to
+// file. Returns -1 on error.
+int play_phrase(const CommandLine *cmd, KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, FILE *log) {
+    int output_rate = cmd->output_rate ? cmd->output_rate : engine->options.sample_rate;
+    FILE *output;
+    int paced = 1;
+    if (cmd->play_file != NULL) {
+        // A FIFO or device plays in real time; a regular file, including a
+        // new one, takes the audio as fast as it is written
+        struct stat file_info;
+        paced = stat(cmd->play_file, &file_info) == 0 && !S_ISREG(file_info.st_mode);
+        output = fopen(cmd->play_file, "wb");
+    } else {
+        char aplay_str[80];
+        snprintf(aplay_str, sizeof(aplay_str), "aplay -q -r %d -c 1 -f %s", output_rate, cmd->ulaw ? "MU_LAW" : "S16_LE");
+        output = popen(aplay_str, "w");
+    }
+    if (output == NULL) {
+        fprintf(stderr, "Error: Could not open %s for playback.\n", cmd->play_file ? cmd->play_file : "aplay");
+        return -1;
+    }
+
+    // A closed pipe then fails the write instead of killing the process
+    signal(SIGPIPE, SIG_IGN);
+    Playback playback;
+    int result = playback_start(&playback, output_rate, paced, cmd->ulaw ? pcm_sink_ulaw_file : pcm_sink_file, output);
+    if (result == 0) {
+        if (stream_phrase(cmd, engine, word_diphones, num_diphones, num_words, playback_sink, &playback) < 0) {
+            result = -1;
+        }
+        if (playback_finish(&playback) != 0) {
+            fprintf(stderr, "Error: Playback output failed.\n");
+            result = -1;
+        }
+        fprintf(log, "Played %lld samples: %d underruns, %d producer waits, peak fill %d of %d samples\n",
+                playback.stats.samples, playback.stats.underruns, playback.stats.producer_waits,
+                playback.stats.peak_fill, playback.stats.capacity);
+    }
+    if (cmd->play_file != NULL) {
+        fclose(output);
+    } else {
+        pclose(output);
+    }
+    return result;
+}
 
-    // Free the allocated buffer
-    free(audio_buffer);
+// Writes the instrumentation counters to the --stats file as JSON.
+// Returns -1 on error.
+int write_stats(const CommandLine *cmd, const KlattStats *stats) {
+    if (cmd->stats_file == NULL) {
+        return 0;
+    }
+    if (strcmp(cmd->stats_file, "-") == 0) {
+        klatt_stats_write_json(stderr, stats);
+        return 0;
+    }
+    FILE *file = fopen(cmd->stats_file, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open file %s for writing.\n", cmd->stats_file);
+        return -1;
+    }
+    klatt_stats_write_json(file, stats);
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Error: Could not write file %s.\n", cmd->stats_file);
+        return -1;
+    }
+    return 0;
 }
 
 // =====================================================================
-// Helper function to synthesize a phrase and save it to a single file
+// Word lookup
 // =====================================================================
-void synthesize_phrase_and_save(const char* filename, const Diphone** word_diphones, int* num_diphones, int num_words) {
-    printf("synthesizing phrase and saving...\n");
-       
-    
-    int total_duration_samples = 0;
-    int pause_samples = SAMPLE_RATE / 4; // A quarter second pause
+// Resolves a word (e.g. "monday", "twenty-first") to its diphone
+// sequence, from the voice bank if one is open. Returns -1 if the word
+// is not known.
+int lookup_word(const char *word, const Diphone **diphones, int *num_diphones) {
+    if (have_voice_bank) {
+        return lookup_bank_word(word, diphones, num_diphones);
+    }
+    return lexicon_find_word(word, diphones, num_diphones);
+}
 
-    // Calculate total duration
-    for (int j = 0; j < num_words; j++) {
-        for (int i = 0; i < num_diphones[j]; i++) {
-            total_duration_samples += (word_diphones[j][i].start_frames + word_diphones[j][i].transition_frames + word_diphones[j][i].end_frames) * (int)(SAMPLE_RATE * FRAME_PERIOD_S);
+// =====================================================================
+// Words from a compiled voice bank (--voicebank)
+// =====================================================================
+int open_voice_bank(const char *path) {
+    if (voicebank_open(&voice_bank, path) != 0) {
+        return -1;
+    }
+    voice_bank_words = (Diphone **)calloc(voice_bank.header->num_words, sizeof(Diphone *));
+    if (voice_bank_words == NULL && voice_bank.header->num_words > 0) {
+        fprintf(stderr, "Error: Could not allocate voice bank word table.\n");
+        voicebank_close(&voice_bank);
+        return -1;
+    }
+    have_voice_bank = 1;
+    return 0;
+}
+
+void close_voice_bank(void) {
+    if (!have_voice_bank) {
+        return;
+    }
+    for (uint32_t i = 0; i < voice_bank.header->num_words; i++) {
+        free(voice_bank_words[i]);
+    }
+    free(voice_bank_words);
+    voice_bank_words = NULL;
+    voicebank_close(&voice_bank);
+    have_voice_bank = 0;
+}
+
+// Looks a word up in the voice bank. Words are resolved before any
+// batch workers start, so the lazily filled table needs no lock.
+int lookup_bank_word(const char *word, const Diphone **diphones, int *num_diphones) {
+    char name[MAX_WORD_NAME];
+    if (lexicon_normalize_word(word, name, sizeof(name)) != 0) {
+        return -1;
+    }
+    int index = voicebank_find_word(&voice_bank, name);
+    if (index < 0) {
+        return -1;
+    }
+    int count = voicebank_word_num_diphones(&voice_bank, index);
+    if (voice_bank_words[index] == NULL) {
+        Diphone *list = (Diphone *)malloc((count > 0 ? count : 1) * sizeof(Diphone));
+        if (list == NULL) {
+            fprintf(stderr, "Error: Could not allocate diphones for '%s'.\n", word);
+            return -1;
         }
-        if (j < num_words - 1) {
-            total_duration_samples += pause_samples;
+        if (voicebank_word_diphones(&voice_bank, index, list, count) != count) {
+            fprintf(stderr, "Error: Voice bank entry for '%s' is corrupt.\n", word);
+            free(list);
+            return -1;
         }
+        voice_bank_words[index] = list;
     }
+    *diphones = voice_bank_words[index];
+    *num_diphones = count;
+    return 0;
+}
 
-    // Allocate a single buffer for the entire phrase
-    double* audio_buffer = (double*)calloc(total_duration_samples, sizeof(double));
-    if (audio_buffer == NULL) {
-        fprintf(stderr, "Error: Could not allocate memory for audio buffer for '%s'.\n", filename);
-        return;
+// =====================================================================
+// Batch mode: render many phrases on a worker pool
+// =====================================================================
+
+// Builds "<out_dir>/<word>_<word>_....wav" for a phrase
+static void make_phrase_filename(BatchPhrase *phrase, const char *out_dir, char words[][32], int num_words) {
+    int len = snprintf(phrase->filename, MAX_BATCH_FILENAME, "%s/", out_dir);
+    for (int i = 0; i < num_words && len < MAX_BATCH_FILENAME; i++) {
+        len += snprintf(phrase->filename + len, MAX_BATCH_FILENAME - len, "%s%s", (i > 0) ? "_" : "", words[i]);
+    }
+    if (len < MAX_BATCH_FILENAME) {
+        snprintf(phrase->filename + len, MAX_BATCH_FILENAME - len, ".wav");
+    }
+}
+
+// Reads one phrase per line (words separated by spaces, e.g.
+// "monday first january") from path, or from stdin if path is "-".
+// Returns the number of phrases loaded, or -1 on error.
+int load_batch_file(const char *path, const char *out_dir, BatchPhrase **phrases) {
+    FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Could not open batch file %s.\n", path);
+        return -1;
     }
 
-  // Reset the synthesis engine state 
-    reset_synthesis_engine_state();
-    
-    int current_sample = 0;
-
-    // Synthesize each word and add a pause
-    for (int j = 0; j < num_words; j++) {
-        for (int i = 0; i < num_diphones[j]; i++) {
-            synthesize_diphone(&word_diphones[j][i], audio_buffer, &current_sample);
-        }
-        // Add a pause between words
-        if (j < num_words - 1) {
-            for (int k = 0; k < pause_samples; k++) {
-                if (current_sample >= total_duration_samples) break;
-                audio_buffer[current_sample++] = 0.0;
+    int capacity = 64;
+    int count = 0;
+    BatchPhrase *list = (BatchPhrase *)malloc(capacity * sizeof(BatchPhrase));
+    if (list == NULL) {
+        fprintf(stderr, "Error: Could not allocate batch phrase list.\n");
+        if (file != stdin) fclose(file);
+        return -1;
+    }
+
+    char line[1024];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char words[MAX_PHRASE_WORDS][32];
+        int num_words = 0;
+        int ok = 1;
+        for (char *token = strtok(line, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n")) {
+            if (num_words >= MAX_PHRASE_WORDS || strlen(token) >= sizeof(words[0])) {
+                fprintf(stderr, "Error: Phrase on line %d is too long.\n", line_number);
+                ok = 0;
+                break;
+            }
+            strcpy(words[num_words++], token);
+        }
+        if (!ok || num_words == 0) {
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            BatchPhrase *grown = (BatchPhrase *)realloc(list, capacity * sizeof(BatchPhrase));
+            if (grown == NULL) {
+                fprintf(stderr, "Error: Could not allocate batch phrase list.\n");
+                free(list);
+                if (file != stdin) fclose(file);
+                return -1;
+            }
+            list = grown;
+        }
+
+        BatchPhrase *phrase = &list[count];
+        phrase->num_words = num_words;
+        for (int i = 0; i < num_words; i++) {
+            if (lookup_word(words[i], &phrase->word_diphones[i], &phrase->num_diphones[i]) != 0) {
+                fprintf(stderr, "Error: Unknown word '%s' on line %d.\n", words[i], line_number);
+                ok = 0;
+                break;
             }
         }
+        if (!ok) {
+            continue;
+        }
+        make_phrase_filename(phrase, out_dir, words, num_words);
+        count++;
     }
-    
-    printf("Synthesis of phrase complete. Writing to %s.\n", filename);
-    normalize_and_write_to_file(filename, audio_buffer, current_sample, SAMPLE_RATE);
-    
-    // Free the allocated memory
-    free(audio_buffer);
+
+    if (file != stdin) fclose(file);
+    *phrases = list;
+    return count;
 }
 
+// Builds every weekday x ordinal x month combination
+int make_all_date_phrases(const char *out_dir, BatchPhrase **phrases) {
+    int count = NUM_WEEKDAYS * NUM_ORDINALS * NUM_MONTHS;
+    BatchPhrase *list = (BatchPhrase *)malloc(count * sizeof(BatchPhrase));
+    if (list == NULL) {
+        fprintf(stderr, "Error: Could not allocate batch phrase list.\n");
+        return -1;
+    }
+
+    int n = 0;
+    for (int w = 0; w < NUM_WEEKDAYS; w++) {
+        for (int d = 1; d <= NUM_ORDINALS; d++) {
+            for (int m = 0; m < NUM_MONTHS; m++) {
+                BatchPhrase *phrase = &list[n++];
+                char words[3][32];
+                snprintf(words[0], sizeof(words[0]), "%s", weekdays[w]);
+                snprintf(words[1], sizeof(words[1]), "%s", ordinal_digits[d - 1]);
+                snprintf(words[2], sizeof(words[2]), "%s", months[m]);
+                phrase->num_words = 3;
+                for (int i = 0; i < 3; i++) {
+                    if (lookup_word(words[i], &phrase->word_diphones[i], &phrase->num_diphones[i]) != 0) {
+                        fprintf(stderr, "Error: No diphones for '%s'.\n", words[i]);
+                        free(list);
+                        return -1;
+                    }
+                }
+                make_phrase_filename(phrase, out_dir, words, 3);
+            }
+        }
+    }
+
+    *phrases = list;
+    return count;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [options]                 speak the current date\n", program);
+    fprintf(stderr, "       %s --say TEXT [options]      speak TEXT (words from the lexicon) to say.wav\n", program);
+    fprintf(stderr, "       %s --phonemes TEXT [options] speak phoneme symbols, e.g. \"HH EH L OW SIL, W ER L D SIL\"\n", program);
+    fprintf(stderr, "       %s --stream [options]        stream the current date (or --say TEXT) to stdout as raw 16-bit PCM\n", program);
+    fprintf(stderr, "       %s --batch FILE [options]    render one WAV per phrase in FILE (- for stdin)\n", program);
+    fprintf(stderr, "       %s --all-dates [options]     render every weekday/ordinal/month phrase\n", program);
+    fprintf(stderr, "       %s --daemon SOCKET [options] serve phrases to klatt_client on a Unix socket\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --out-dir DIR   directory for batch WAV files (default .)\n");
+    fprintf(stderr, "  --threads N     number of batch worker threads (default: one per core)\n");
+    fprintf(stderr, "  --cache MB      keep up to MB megabytes of rendered batch phrases for repeats\n");
+    fprintf(stderr, "  --segments      assemble batch phrases from words rendered once\n");
+    fprintf(stderr, "  --voicebank FILE  read phonemes and words from a compiled voice bank\n");
+    fprintf(stderr, "  --rate HZ       output sample rate, %d to %d (default %d)\n", MIN_SAMPLE_RATE, MAX_SAMPLE_RATE, SAMPLE_RATE);
+    fprintf(stderr, "  --output-rate HZ  resample the date or --say output to HZ (e.g. 8000 or 48000)\n");
+    fprintf(stderr, "  --ulaw          write 8-bit mu-law instead of 16-bit PCM\n");
+    fprintf(stderr, "  --play          play the date or --say text through aplay while it is synthesized\n");
+    fprintf(stderr, "  --play-to FILE  play into FILE (e.g. a FIFO) as raw samples instead of aplay\n");
+    fprintf(stderr, "  --stats FILE    write the instrumentation counters as JSON (- for stderr);\n");
+    fprintf(stderr, "                  they are only counted when built with -DKLATT_STATS\n");
+    fprintf(stderr, "  --ramp FRAMES   ramp formant coefficients per sample, updating them every\n");
+    fprintf(stderr, "                  FRAMES 10 ms frames during transitions (e.g. 2-4)\n");
+}
+
+// Fills cmd from the arguments. Returns -1 (after printing the usage)
+// if they are not valid.
+int parse_command_line(int argc, char **argv, CommandLine *cmd) {
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->out_dir = ".";
+    default_klatt_options(&cmd->options);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            cmd->stream = 1;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            cmd->batch_file = argv[++i];
+        } else if (strcmp(argv[i], "--all-dates") == 0) {
+            cmd->all_dates = 1;
+        } else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            cmd->out_dir = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            cmd->num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cmd->cache_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segments") == 0) {
+            cmd->segments = 1;
+        } else if (strcmp(argv[i], "--say") == 0 && i + 1 < argc) {
+            cmd->say_text = argv[++i];
+        } else if (strcmp(argv[i], "--phonemes") == 0 && i + 1 < argc) {
+            cmd->phoneme_text = argv[++i];
+        } else if (strcmp(argv[i], "--voicebank") == 0 && i + 1 < argc) {
+            cmd->voicebank_file = argv[++i];
+        } else if (strcmp(argv[i], "--ramp") == 0 && i + 1 < argc) {
+            cmd->options.coefficient_ramp = 1;
+            cmd->options.control_period_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            cmd->options.sample_rate = atoi(argv[++i]);
+            if (!sample_rate_supported(cmd->options.sample_rate)) {
+                fprintf(stderr, "Error: Sample rate %s is outside %d-%d Hz.\n", argv[i], MIN_SAMPLE_RATE, MAX_SAMPLE_RATE);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--output-rate") == 0 && i + 1 < argc) {
+            cmd->output_rate = atoi(argv[++i]);
+            if (cmd->output_rate <= 0) {
+                fprintf(stderr, "Error: Invalid output rate %s.\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            cmd->stats_file = argv[++i];
+        } else if (strcmp(argv[i], "--daemon") == 0 && i + 1 < argc) {
+            cmd->daemon_socket = argv[++i];
+        } else if (strcmp(argv[i], "--play") == 0) {
+            cmd->play = 1;
+        } else if (strcmp(argv[i], "--play-to") == 0 && i + 1 < argc) {
+            cmd->play_file = argv[++i];
+        } else if (strcmp(argv[i], "--ulaw") == 0) {
+            cmd->ulaw = 1;
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    int play = cmd->play || cmd->play_file != NULL;
+    if ((cmd->batch_file != NULL) + cmd->all_dates + cmd->stream + (cmd->daemon_socket != NULL) + play > 1
+        || (cmd->say_text != NULL && cmd->phoneme_text != NULL)
+        || ((cmd->batch_file != NULL || cmd->all_dates || cmd->daemon_socket != NULL)
+            && (cmd->say_text != NULL || cmd->phoneme_text != NULL || cmd->output_rate || cmd->ulaw))) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+int run_batch_mode(const CommandLine *cmd) {
+    BatchPhrase *phrases = NULL;
+    int num_phrases = cmd->all_dates ? make_all_date_phrases(cmd->out_dir, &phrases)
+                                     : load_batch_file(cmd->batch_file, cmd->out_dir, &phrases);
+    if (num_phrases < 0) {
+        return 1;
+    }
+
+    PcmCache cache;
+    PcmCache *phrase_cache = NULL;
+    if (cmd->cache_mb > 0) {
+        if (pcm_cache_init(&cache, (size_t)cmd->cache_mb * 1048576) != 0) {
+            free(phrases);
+            return 1;
+        }
+        phrase_cache = &cache;
+    }
 
+    SegmentStore store;
+    SegmentStore *segments = NULL;
+    if (cmd->segments) {
+        if (segment_store_build(&store, &cmd->options) != 0) {
+            if (phrase_cache != NULL) pcm_cache_destroy(phrase_cache);
+            free(phrases);
+            return 1;
+        }
+        segments = &store;
+    }
+
+    BatchStats stats;
+    int result = run_batch(phrases, num_phrases, cmd->num_threads, &cmd->options, phrase_cache, segments, &stats);
+    print_batch_stats(stdout, &stats);
+    write_stats(cmd, &stats.engine_stats);
+    if (phrase_cache != NULL) {
+        print_pcm_cache_stats(stdout, phrase_cache);
+        pcm_cache_destroy(phrase_cache);
+    }
+    if (segments != NULL) {
+        segment_store_free(segments);
+    }
+
+    free(phrases);
+    return (result == 0) ? 0 : 1;
+}
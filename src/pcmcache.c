@@ -0,0 +1,213 @@
+/* pcmcache.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pcmcache.h"
+
+int pcm_cache_init(PcmCache *cache, size_t budget_bytes) {
+    memset(cache, 0, sizeof(*cache));
+    cache->budget_bytes = budget_bytes;
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        fprintf(stderr, "Error: Could not initialize PCM cache lock.\n");
+        return -1;
+    }
+    return 0;
+}
+
+void pcm_cache_destroy(PcmCache *cache) {
+    PcmCacheEntry *entry = cache->most_recent;
+    while (entry != NULL) {
+        PcmCacheEntry *older = entry->older;
+        free(entry->samples);
+        free(entry);
+        entry = older;
+    }
+    pthread_mutex_destroy(&cache->lock);
+    memset(cache->buckets, 0, sizeof(cache->buckets));
+    cache->most_recent = cache->least_recent = NULL;
+    cache->used_bytes = 0;
+    cache->num_entries = 0;
+}
+
+int pcm_cache_make_key(PcmCacheKey *key, const Diphone* const* word_diphones, const int* num_diphones, int num_words, const KlattOptions *options) {
+    if (num_words > PCM_CACHE_MAX_WORDS) {
+        return -1;
+    }
+    // Keys are compared with memcmp, so unused words must be zero
+    memset(key, 0, sizeof(*key));
+    key->num_words = num_words;
+    for (int i = 0; i < num_words; i++) {
+        key->word_diphones[i] = word_diphones[i];
+        key->num_diphones[i] = num_diphones[i];
+    }
+    key->options = *options;
+    return 0;
+}
+
+// FNV-1a over the bytes of the key
+static uint32_t hash_key(const PcmCacheKey *key) {
+    const unsigned char *bytes = (const unsigned char *)key;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(*key); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static PcmCacheEntry *find_entry(PcmCache *cache, const PcmCacheKey *key, uint32_t hash) {
+    for (PcmCacheEntry *entry = cache->buckets[hash & (PCM_CACHE_BUCKETS - 1)]; entry != NULL; entry = entry->next_in_bucket) {
+        if (entry->hash == hash && memcmp(&entry->key, key, sizeof(*key)) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void unlink_lru(PcmCache *cache, PcmCacheEntry *entry) {
+    if (entry->newer) entry->newer->older = entry->older; else cache->most_recent = entry->older;
+    if (entry->older) entry->older->newer = entry->newer; else cache->least_recent = entry->newer;
+    entry->newer = entry->older = NULL;
+}
+
+static void push_most_recent(PcmCache *cache, PcmCacheEntry *entry) {
+    entry->older = cache->most_recent;
+    entry->newer = NULL;
+    if (cache->most_recent) cache->most_recent->newer = entry; else cache->least_recent = entry;
+    cache->most_recent = entry;
+}
+
+static void evict_least_recent(PcmCache *cache) {
+    PcmCacheEntry *entry = cache->least_recent;
+    unlink_lru(cache, entry);
+    PcmCacheEntry **link = &cache->buckets[entry->hash & (PCM_CACHE_BUCKETS - 1)];
+    while (*link != entry) {
+        link = &(*link)->next_in_bucket;
+    }
+    *link = entry->next_in_bucket;
+
+    cache->used_bytes -= entry->bytes;
+    cache->num_entries--;
+    cache->evictions++;
+    free(entry->samples);
+    free(entry);
+}
+
+int pcm_cache_get(PcmCache *cache, const PcmCacheKey *key, Arena *arena, int16_t **samples) {
+    uint32_t hash = hash_key(key);
+    int num_samples = -1;
+
+    pthread_mutex_lock(&cache->lock);
+    PcmCacheEntry *entry = find_entry(cache, key, hash);
+    if (entry != NULL) {
+        *samples = (int16_t *)arena_alloc(arena, (size_t)(entry->num_samples > 0 ? entry->num_samples : 1) * sizeof(int16_t));
+        if (*samples != NULL) {
+            memcpy(*samples, entry->samples, entry->num_samples * sizeof(int16_t));
+            num_samples = entry->num_samples;
+            unlink_lru(cache, entry);
+            push_most_recent(cache, entry);
+        }
+    }
+    if (num_samples >= 0) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return num_samples;
+}
+
+void pcm_cache_put(PcmCache *cache, const PcmCacheKey *key, const int16_t *samples, int num_samples) {
+    size_t bytes = sizeof(PcmCacheEntry) + num_samples * sizeof(int16_t);
+    if (bytes > cache->budget_bytes) {
+        return; // Would evict everything and still not fit
+    }
+
+    // Copy outside the lock
+    PcmCacheEntry *entry = (PcmCacheEntry *)malloc(sizeof(PcmCacheEntry));
+    int16_t *copy = (int16_t *)malloc((num_samples > 0 ? num_samples : 1) * sizeof(int16_t));
+    if (entry == NULL || copy == NULL) {
+        free(entry);
+        free(copy);
+        return;
+    }
+    memcpy(copy, samples, num_samples * sizeof(int16_t));
+    memcpy(&entry->key, key, sizeof(*key)); // Includes the zeroed padding
+    entry->hash = hash_key(key);
+    entry->samples = copy;
+    entry->num_samples = num_samples;
+    entry->bytes = bytes;
+
+    pthread_mutex_lock(&cache->lock);
+    if (find_entry(cache, key, entry->hash) != NULL) {
+        // Another thread rendered the same phrase first
+        pthread_mutex_unlock(&cache->lock);
+        free(copy);
+        free(entry);
+        return;
+    }
+    while (cache->used_bytes + bytes > cache->budget_bytes) {
+        evict_least_recent(cache);
+    }
+    PcmCacheEntry **bucket = &cache->buckets[entry->hash & (PCM_CACHE_BUCKETS - 1)];
+    entry->next_in_bucket = *bucket;
+    *bucket = entry;
+    push_most_recent(cache, entry);
+    cache->used_bytes += bytes;
+    cache->num_entries++;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+int synthesize_phrase_and_save_cached(PcmCache *cache, KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words) {
+    PcmCacheKey key;
+    if (cache == NULL || pcm_cache_make_key(&key, word_diphones, num_diphones, num_words, &engine->options) != 0) {
+        return synthesize_phrase_and_save(engine, filename, word_diphones, num_diphones, num_words);
+    }
+
+    // The samples are scratch memory of the engine, released on return
+    ArenaMark mark = arena_mark(&engine->scratch);
+    int16_t *pcm = NULL;
+    int num_samples = pcm_cache_get(cache, &key, &engine->scratch, &pcm);
+    if (num_samples < 0) {
+        num_samples = synthesize_phrase_pcm_scratch(engine, word_diphones, num_diphones, num_words, &pcm);
+        if (num_samples < 0) {
+            arena_rewind(&engine->scratch, mark);
+            return -1;
+        }
+        pcm_cache_put(cache, &key, pcm, num_samples);
+    }
+
+    KLATT_STATS_START(write_start);
+    int result = write_wav_file(filename, pcm, num_samples, engine->options.sample_rate);
+    KLATT_STATS_STOP(&engine->stats, wav_write_ns, write_start);
+    KLATT_STATS_ADD(&engine->stats, wav_files, 1);
+    arena_rewind(&engine->scratch, mark);
+    return (result == 0) ? num_samples : -1;
+}
+
+void print_pcm_cache_stats(FILE *out, PcmCache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    unsigned long lookups = cache->hits + cache->misses;
+    double hit_rate = (lookups > 0) ? 100.0 * cache->hits / lookups : 0.0;
+    fprintf(out, "PCM cache: %lu hits, %lu misses (%.1f%% hit rate), %lu evictions, %d phrases in %.1f of %.1f MB\n",
+            cache->hits, cache->misses, hit_rate, cache->evictions, cache->num_entries,
+            cache->used_bytes / 1048576.0, cache->budget_bytes / 1048576.0);
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,97 @@
+/* pcmcache.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Least-recently-used cache of rendered phrases. A phrase is keyed by
+// its word sequence and the engine options it was rendered with, and
+// holds the normalized 16-bit samples, so a repeated request is a copy
+// instead of a full synthesis. The cache is bounded by a memory budget
+// and may be shared by several threads.
+// =====================================================================
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "phonemes.h"
+#include "synthesizer.h"
+
+#define PCM_CACHE_MAX_WORDS 16 // Longer phrases are not cached
+#define PCM_CACHE_BUCKETS 4096 // Must be a power of two
+
+// Words are identified by their diphone arrays, which stay at the same
+// address for the life of the process
+typedef struct {
+    int num_words;
+    const Diphone *word_diphones[PCM_CACHE_MAX_WORDS];
+    int num_diphones[PCM_CACHE_MAX_WORDS];
+    KlattOptions options;
+} PcmCacheKey;
+
+typedef struct PcmCacheEntry {
+    PcmCacheKey key;
+    uint32_t hash;
+    int16_t *samples;
+    int num_samples;
+    size_t bytes; // Memory charged to the budget
+    struct PcmCacheEntry *newer; // LRU list, most recent first
+    struct PcmCacheEntry *older;
+    struct PcmCacheEntry *next_in_bucket;
+} PcmCacheEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PcmCacheEntry *buckets[PCM_CACHE_BUCKETS];
+    PcmCacheEntry *most_recent;
+    PcmCacheEntry *least_recent;
+    size_t budget_bytes;
+    size_t used_bytes;
+    int num_entries;
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} PcmCache;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+int pcm_cache_init(PcmCache *cache, size_t budget_bytes);
+void pcm_cache_destroy(PcmCache *cache);
+
+// Builds the key of a phrase. Returns -1 if it has too many words.
+int pcm_cache_make_key(PcmCacheKey *key, const Diphone* const* word_diphones, const int* num_diphones, int num_words, const KlattOptions *options);
+
+// On a hit, sets *samples to a copy in arena memory and returns the
+// number of samples. Returns -1 on a miss.
+int pcm_cache_get(PcmCache *cache, const PcmCacheKey *key, Arena *arena, int16_t **samples);
+
+// Stores a copy of the samples, evicting the least recently used
+// phrases to stay within the budget
+void pcm_cache_put(PcmCache *cache, const PcmCacheKey *key, const int16_t *samples, int num_samples);
+
+// synthesize_phrase_and_save() that takes the samples from the cache
+// when it can. A NULL cache renders every time.
+int synthesize_phrase_and_save_cached(PcmCache *cache, KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words);
+
+void print_pcm_cache_stats(FILE *out, PcmCache *cache);
+
+#endif // PCMCACHE_H
@@ -0,0 +1,232 @@
+/* playback.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Lock-free ring buffer between synthesis and the audio output thread
+// =====================================================================
+#define _POSIX_C_SOURCE 200809L
+
+#include "playback.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PLAYBACK_POLL_NS 1000000 // Sleep while waiting for the ring to fill or drain
+
+static void playback_sleep(void) {
+    struct timespec delay = {0, PLAYBACK_POLL_NS};
+    nanosleep(&delay, NULL);
+}
+
+// Allocates a ring of at least min_capacity samples. Returns -1 on error.
+int pcm_ring_init(PcmRing *ring, int min_capacity) {
+    memset(ring, 0, sizeof(*ring));
+    size_t capacity = 1;
+    while (capacity < (size_t)min_capacity) {
+        capacity *= 2;
+    }
+    ring->samples = (int16_t *)malloc(capacity * sizeof(int16_t));
+    if (ring->samples == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for the playback buffer.\n");
+        return -1;
+    }
+    ring->mask = capacity - 1;
+    return 0;
+}
+
+void pcm_ring_free(PcmRing *ring) {
+    free(ring->samples);
+    ring->samples = NULL;
+}
+
+// Samples buffered. Exact from either side, a lower bound for the
+// consumer and an upper bound for the producer while the other runs.
+int pcm_ring_fill(const PcmRing *ring) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    return (int)(head - tail);
+}
+
+// Producer side: copies as many samples as fit and returns their number
+int pcm_ring_write(PcmRing *ring, const int16_t *samples, int num_samples) {
+    size_t head = ring->head; // Only this thread writes it
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t space = ring->mask + 1 - (head - tail);
+    size_t n = ((size_t)num_samples < space) ? (size_t)num_samples : space;
+
+    size_t start = head & ring->mask;
+    size_t first = ring->mask + 1 - start;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(ring->samples + start, samples, first * sizeof(int16_t));
+    memcpy(ring->samples, samples + first, (n - first) * sizeof(int16_t));
+    __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+    return (int)n;
+}
+
+// Consumer side: copies up to max_samples and returns their number
+int pcm_ring_read(PcmRing *ring, int16_t *samples, int max_samples) {
+    size_t tail = ring->tail; // Only this thread writes it
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t available = head - tail;
+    size_t n = ((size_t)max_samples < available) ? (size_t)max_samples : available;
+
+    size_t start = tail & ring->mask;
+    size_t first = ring->mask + 1 - start;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(samples, ring->samples + start, first * sizeof(int16_t));
+    memcpy(samples + first, ring->samples, (n - first) * sizeof(int16_t));
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+    return (int)n;
+}
+
+// =====================================================================
+// Output thread
+// =====================================================================
+static long long playback_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void playback_sleep_until(long long deadline_ns) {
+    struct timespec deadline = {(time_t)(deadline_ns / 1000000000LL), (long)(deadline_ns % 1000000000LL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) != 0) {
+    }
+}
+
+// Waits until the ring holds samples or the producer has finished, e.g.
+// for the prefill. Returns the samples buffered.
+static int playback_wait_for(Playback *playback, int num_samples) {
+    for (;;) {
+        // Read finished before the ring so no samples are missed after it
+        int finished = __atomic_load_n(&playback->finished, __ATOMIC_ACQUIRE);
+        int fill = pcm_ring_fill(&playback->ring);
+        if (fill >= num_samples || finished) {
+            return fill;
+        }
+        playback_sleep();
+    }
+}
+
+// When paced, hands one period to the sink every period, like a sound
+// card clock, so the sink never holds more than a period and an underrun
+// means that synthesis fell behind real time. Otherwise drains the ring
+// as fast as the sink takes it.
+static void *playback_thread(void *arg) {
+    Playback *playback = (Playback *)arg;
+    int16_t period[MAX_FRAME_SAMPLES];
+    long long period_ns = (long long)playback->period_samples * 1000000000LL / playback->sample_rate;
+
+    playback_wait_for(playback, playback->prefill_samples);
+    long long deadline = playback_now_ns();
+    for (;;) {
+        if (!playback->paced) {
+            // A file has no clock: write periods as soon as they are ready
+            playback_wait_for(playback, playback->period_samples);
+        } else if (pcm_ring_fill(&playback->ring) < playback->period_samples
+                   && !__atomic_load_n(&playback->finished, __ATOMIC_ACQUIRE)) {
+            // Underrun: wait for the next period and restart the clock
+            playback->stats.underruns++;
+            playback_wait_for(playback, playback->period_samples);
+            deadline = playback_now_ns();
+        }
+        int n = pcm_ring_read(&playback->ring, period, playback->period_samples);
+        if (n == 0) {
+            break; // Finished and drained
+        }
+        if (playback->sink(playback->user_data, period, n) != 0) {
+            __atomic_store_n(&playback->failed, 1, __ATOMIC_RELEASE);
+            break;
+        }
+        playback->stats.samples += n;
+        if (playback->paced) {
+            deadline += period_ns;
+            playback_sleep_until(deadline);
+        }
+    }
+    return NULL;
+}
+
+// Starts the output thread, which passes the audio to sink, at the
+// sample rate if paced (for a player or a FIFO) or as fast as it can (for
+// a regular file). Returns -1 on error.
+int playback_start(Playback *playback, int sample_rate, int paced, PcmSink sink, void *user_data) {
+    memset(playback, 0, sizeof(*playback));
+    if (pcm_ring_init(&playback->ring, sample_rate * PLAYBACK_BUFFER_MS / 1000) != 0) {
+        return -1;
+    }
+    playback->sink = sink;
+    playback->sample_rate = sample_rate;
+    playback->paced = paced;
+    playback->user_data = user_data;
+    playback->period_samples = sample_rate * FRAME_PERIOD_MS / 1000;
+    if (playback->period_samples > MAX_FRAME_SAMPLES) {
+        playback->period_samples = MAX_FRAME_SAMPLES;
+    }
+    playback->prefill_samples = sample_rate * PLAYBACK_PREFILL_MS / 1000;
+    playback->stats.capacity = (int)(playback->ring.mask + 1);
+    if (pthread_create(&playback->thread, NULL, playback_thread, playback) != 0) {
+        fprintf(stderr, "Error: Could not start the playback thread.\n");
+        pcm_ring_free(&playback->ring);
+        return -1;
+    }
+    return 0;
+}
+
+// PcmSink for the synthesis thread: queues a block for the output thread,
+// waiting while the ring is full. Returns -1 if the output has failed.
+int playback_sink(void *user_data, const int16_t *samples, int num_samples) {
+    Playback *playback = (Playback *)user_data;
+    int waited = 0;
+    while (num_samples > 0) {
+        if (__atomic_load_n(&playback->failed, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        int n = pcm_ring_write(&playback->ring, samples, num_samples);
+        samples += n;
+        num_samples -= n;
+        int fill = pcm_ring_fill(&playback->ring);
+        if (fill > playback->stats.peak_fill) {
+            playback->stats.peak_fill = fill;
+        }
+        if (num_samples > 0) {
+            if (!waited) {
+                playback->stats.producer_waits++;
+                waited = 1;
+            }
+            playback_sleep();
+        }
+    }
+    return 0;
+}
+
+// Lets the output thread drain the ring and waits for it. Returns -1 if
+// the output failed.
+int playback_finish(Playback *playback) {
+    __atomic_store_n(&playback->finished, 1, __ATOMIC_RELEASE);
+    pthread_join(playback->thread, NULL);
+    pcm_ring_free(&playback->ring);
+    return playback->failed ? -1 : 0;
+}
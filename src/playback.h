@@ -0,0 +1,89 @@
+/* playback.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// In-process playback. The synthesis thread pushes each rendered block
+// into a lock-free single-producer/single-consumer ring buffer and an
+// output thread drains it to a PcmSink (a pipe into aplay, a FIFO or a
+// file) one frame sized period at a time, paced by the clock at the
+// sample rate unless the sink is a regular file. Playback starts once PLAYBACK_PREFILL_MS of audio is
+// buffered instead of after the whole phrase, and periods that are not
+// ready in time are counted as underruns.
+// =====================================================================
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "synthesizer.h"
+
+#define PLAYBACK_BUFFER_MS 200 // Ring capacity (rounded up to a power of two samples)
+#define PLAYBACK_PREFILL_MS 20 // Audio buffered before the output starts
+#define PCM_RING_PAD 64        // Keeps the two indices on separate cache lines
+
+// Ring of 16-bit samples. head is only written by the producer and tail
+// only by the consumer; each publishes with a release store and reads
+// the other's index with an acquire load. Both count samples since the
+// start and wrap through mask.
+typedef struct {
+    int16_t *samples;
+    size_t mask;      // Capacity - 1, the capacity is a power of two
+    char pad0[PCM_RING_PAD];
+    size_t head;      // Next sample to write
+    char pad1[PCM_RING_PAD];
+    size_t tail;      // Next sample to read
+    char pad2[PCM_RING_PAD];
+} PcmRing;
+
+// Counters of one playback, read after playback_finish()
+typedef struct {
+    long long samples;  // Samples passed to the output sink
+    int underruns;      // Periods that were not buffered when they were due (paced only)
+    int producer_waits; // Times synthesis found the ring full
+    int peak_fill;      // Most samples buffered at once
+    int capacity;       // Ring capacity in samples
+} PlaybackStats;
+
+typedef struct {
+    PcmRing ring;
+    PcmSink sink;          // Output, called from the output thread
+    void *user_data;
+    int sample_rate;
+    int paced;             // Hand out periods at the sample rate, or as fast as the sink takes them
+    int period_samples;    // Samples per sink call, one every FRAME_PERIOD_MS when paced
+    int prefill_samples;
+    int finished;          // Set by the producer when no more samples come
+    int failed;            // Set by the output thread if the sink fails
+    pthread_t thread;
+    PlaybackStats stats;
+} Playback;
+
+int pcm_ring_init(PcmRing *ring, int min_capacity);
+void pcm_ring_free(PcmRing *ring);
+int pcm_ring_fill(const PcmRing *ring);
+int pcm_ring_write(PcmRing *ring, const int16_t *samples, int num_samples);
+int pcm_ring_read(PcmRing *ring, int16_t *samples, int max_samples);
+
+int playback_start(Playback *playback, int sample_rate, int paced, PcmSink sink, void *user_data);
+int playback_sink(void *user_data, const int16_t *samples, int num_samples);
+int playback_finish(Playback *playback);
+
+#endif // PLAYBACK_H
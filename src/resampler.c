@@ -0,0 +1,314 @@
+/* resampler.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "resampler.h"
+#include "wav.h"
+
+#define KAISER_BETA 8.0 // About 80 dB of stopband attenuation
+
+static int greatest_common_divisor(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Designs the prototype low-pass filter at up times the input rate and
+// splits it into up phases. Phase p holds taps p, p + up, p + 2 up ...
+// stored in reverse, so that each output is a dot product with
+// consecutive input samples. The filter is shortened so that its delay
+// is a whole number of output samples, which resampler_reset() skips.
+// Returns -1 on error.
+static int design_filter(Resampler *resampler) {
+    int up = resampler->up;
+    int taps = resampler->taps;
+    int length = up * taps;
+    double cutoff = RESAMPLER_CUTOFF * 0.5 / (up > resampler->down ? up : resampler->down);
+    int span = (length - 1) / (2 * resampler->down) * 2 * resampler->down;
+    double center = span / 2.0;
+    double window_norm = bessel_i0(KAISER_BETA);
+    double *prototype = (double *)malloc(length * sizeof(double));
+    if (prototype == NULL) {
+        return -1;
+    }
+    double sum = 0.0;
+
+    for (int i = 0; i < length; i++) {
+        if (i > span) {
+            prototype[i] = 0.0;
+            continue;
+        }
+        double x = i - center;
+        double sinc = (x == 0.0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        double w = x / center;
+        double window = bessel_i0(KAISER_BETA * sqrt(1.0 - w * w)) / window_norm;
+        prototype[i] = sinc * window;
+        sum += prototype[i];
+    }
+
+    // Unity gain in every phase after the zeros inserted by upsampling
+    for (int p = 0; p < up; p++) {
+        for (int j = 0; j < taps; j++) {
+            resampler->coefficients[p * taps + j] = (float)(prototype[p + (taps - 1 - j) * up] * up / sum);
+        }
+    }
+    free(prototype);
+    return 0;
+}
+
+// Prepares a resampler from input_rate to output_rate. Returns -1 on error.
+int resampler_init(Resampler *resampler, int input_rate, int output_rate) {
+    memset(resampler, 0, sizeof(*resampler));
+    if (input_rate <= 0 || output_rate <= 0) {
+        fprintf(stderr, "Error: Invalid resampling rates %d to %d Hz.\n", input_rate, output_rate);
+        return -1;
+    }
+    int divisor = greatest_common_divisor(input_rate, output_rate);
+    resampler->input_rate = input_rate;
+    resampler->output_rate = output_rate;
+    resampler->up = output_rate / divisor;
+    resampler->down = input_rate / divisor;
+
+    // Decimating narrows the passband, which takes proportionally more taps
+    int taps = RESAMPLER_TAPS;
+    if (resampler->down > resampler->up) {
+        taps = (RESAMPLER_TAPS * resampler->down + resampler->up - 1) / resampler->up;
+    }
+    resampler->taps = (taps + 7) & ~7;
+
+    int max_output = (int)((long)RESAMPLER_CHUNK * resampler->up / resampler->down) + 2;
+    resampler->coefficients = (float *)malloc((size_t)resampler->up * resampler->taps * sizeof(float));
+    resampler->history = (float *)malloc((resampler->taps - 1 + RESAMPLER_CHUNK) * sizeof(float));
+    resampler->output = (int16_t *)malloc(max_output * sizeof(int16_t));
+    if (resampler->coefficients == NULL || resampler->history == NULL || resampler->output == NULL
+        || design_filter(resampler) != 0) {
+        fprintf(stderr, "Error: Could not allocate the resampler.\n");
+        resampler_free(resampler);
+        return -1;
+    }
+    resampler_reset(resampler);
+    return 0;
+}
+
+void resampler_free(Resampler *resampler) {
+    free(resampler->coefficients);
+    free(resampler->history);
+    free(resampler->output);
+    resampler->coefficients = NULL;
+    resampler->history = NULL;
+    resampler->output = NULL;
+}
+
+// Clears the filter history to start a new stream
+void resampler_reset(Resampler *resampler) {
+    memset(resampler->history, 0, (resampler->taps - 1) * sizeof(float));
+    resampler->next_input = 0;
+    resampler->phase = 0;
+    // The prototype filter delays by half its span at the upsampled rate
+    resampler->skip = (resampler->up * resampler->taps - 1) / (2 * resampler->down);
+}
+
+// Dot product of one phase with the input. Eight partial sums keep the
+// products independent so the loop maps onto SIMD registers.
+static float filter_phase(const float *coefficients, const float *input, int taps) {
+    float sum[8] = {0};
+    for (int j = 0; j < taps; j += 8) {
+        for (int k = 0; k < 8; k++) {
+            sum[k] += coefficients[j + k] * input[j + k];
+        }
+    }
+    return ((sum[0] + sum[1]) + (sum[2] + sum[3])) + ((sum[4] + sum[5]) + (sum[6] + sum[7]));
+}
+
+static int16_t float_to_pcm(float x) {
+    if (x >= 32767.0f) {
+        return 32767;
+    }
+    if (x <= -32768.0f) {
+        return -32768;
+    }
+    return (int16_t)lrintf(x);
+}
+
+// Filters one chunk of at most RESAMPLER_CHUNK samples
+static int process_chunk(Resampler *resampler, const int16_t *input, int num_input, PcmSink sink, void *user_data) {
+    int taps = resampler->taps;
+    float *window = resampler->history;
+    for (int i = 0; i < num_input; i++) {
+        window[taps - 1 + i] = input[i];
+    }
+
+    int num_output = 0;
+    while (resampler->next_input < num_input) {
+        const float *coefficients = resampler->coefficients + resampler->phase * taps;
+        float y = filter_phase(coefficients, window + resampler->next_input, taps);
+        if (resampler->skip > 0) {
+            resampler->skip--;
+        } else {
+            resampler->output[num_output++] = float_to_pcm(y);
+        }
+        resampler->phase += resampler->down;
+        resampler->next_input += resampler->phase / resampler->up;
+        resampler->phase %= resampler->up;
+    }
+    resampler->next_input -= num_input;
+    memmove(window, window + num_input, (taps - 1) * sizeof(float));
+
+    if (num_output > 0) {
+        return sink(user_data, resampler->output, num_output);
+    }
+    return 0;
+}
+
+// Resamples a block of the stream and passes the output to sink.
+// Returns nonzero if the sink asked to stop.
+int resampler_process(Resampler *resampler, const int16_t *input, int num_input, PcmSink sink, void *user_data) {
+    for (int done = 0; done < num_input; done += RESAMPLER_CHUNK) {
+        int chunk = (num_input - done < RESAMPLER_CHUNK) ? num_input - done : RESAMPLER_CHUNK;
+        int result = process_chunk(resampler, input + done, chunk, sink, user_data);
+        if (result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+// Pushes silence through the filter so the end of the stream comes out
+int resampler_flush(Resampler *resampler, PcmSink sink, void *user_data) {
+    int16_t silence[RESAMPLER_CHUNK] = {0};
+    int remaining = resampler->taps / 2 + 1;
+    while (remaining > 0) {
+        int chunk = (remaining < RESAMPLER_CHUNK) ? remaining : RESAMPLER_CHUNK;
+        int result = process_chunk(resampler, silence, chunk, sink, user_data);
+        if (result != 0) {
+            return result;
+        }
+        remaining -= chunk;
+    }
+    return 0;
+}
+
+// Collects resampled output into a buffer of fixed capacity
+typedef struct {
+    int16_t *samples;
+    int num_samples;
+    int capacity;
+} PcmCollector;
+
+static int collect_pcm(void *user_data, const int16_t *samples, int num_samples) {
+    PcmCollector *collector = (PcmCollector *)user_data;
+    int room = collector->capacity - collector->num_samples;
+    int n = (num_samples < room) ? num_samples : room;
+    memcpy(collector->samples + collector->num_samples, samples, n * sizeof(int16_t));
+    collector->num_samples += n;
+    return 0;
+}
+
+// Resamples a whole buffer. The output has num_input * output_rate /
+// input_rate samples, lined up with the input. Returns the number of
+// samples and sets *output to a buffer the caller frees, or returns -1.
+int resample_pcm(const int16_t *input, int num_input, int input_rate, int output_rate, int16_t **output) {
+    Resampler resampler;
+    if (resampler_init(&resampler, input_rate, output_rate) != 0) {
+        return -1;
+    }
+
+    long num_output = (long)num_input * output_rate / input_rate;
+    if (num_output > INT32_MAX) {
+        fprintf(stderr, "Error: Resampled output is too long.\n");
+        resampler_free(&resampler);
+        return -1;
+    }
+    PcmCollector collector = {0};
+    collector.capacity = (int)num_output;
+    collector.samples = (int16_t *)malloc((num_output > 0 ? num_output : 1) * sizeof(int16_t));
+    if (collector.samples == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for resampled samples.\n");
+        resampler_free(&resampler);
+        return -1;
+    }
+
+    resampler_process(&resampler, input, num_input, collect_pcm, &collector);
+    resampler_flush(&resampler, collect_pcm, &collector);
+    resampler_free(&resampler);
+
+    *output = collector.samples;
+    return collector.num_samples;
+}
+
+// =====================================================================
+// PcmSink adapter
+// =====================================================================
+int resampler_sink_init(ResamplerSink *resampler_sink, int input_rate, int output_rate, PcmSink sink, void *user_data) {
+    resampler_sink->sink = sink;
+    resampler_sink->user_data = user_data;
+    return resampler_init(&resampler_sink->resampler, input_rate, output_rate);
+}
+
+// PcmSink that resamples; user_data is the ResamplerSink
+int resampler_sink(void *user_data, const int16_t *samples, int num_samples) {
+    ResamplerSink *resampler_sink = (ResamplerSink *)user_data;
+    return resampler_process(&resampler_sink->resampler, samples, num_samples, resampler_sink->sink, resampler_sink->user_data);
+}
+
+// Passes the end of the stream still held in the filter to the sink
+int resampler_sink_finish(ResamplerSink *resampler_sink) {
+    return resampler_flush(&resampler_sink->resampler, resampler_sink->sink, resampler_sink->user_data);
+}
+
+void resampler_sink_free(ResamplerSink *resampler_sink) {
+    resampler_free(&resampler_sink->resampler);
+}
+
+// =====================================================================
+// Mu-law output
+// =====================================================================
+// PcmSink that writes mu-law bytes to the FILE* passed as user data
+int pcm_sink_ulaw_file(void *user_data, const int16_t *samples, int num_samples) {
+    FILE *file = (FILE *)user_data;
+    uint8_t bytes[RESAMPLER_CHUNK];
+    for (int done = 0; done < num_samples; done += RESAMPLER_CHUNK) {
+        int n = (num_samples - done < RESAMPLER_CHUNK) ? num_samples - done : RESAMPLER_CHUNK;
+        for (int i = 0; i < n; i++) {
+            bytes[i] = linear_to_ulaw(samples[done + i]);
+        }
+        if (fwrite(bytes, 1, n, file) != (size_t)n) {
+            return -1;
+        }
+    }
+    return fflush(file);
+}
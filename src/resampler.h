@@ -0,0 +1,75 @@
+/* resampler.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Output rate conversion. The engine renders at its own rate and a
+// Resampler converts the 16-bit output to another rate with a polyphase
+// windowed-sinc filter, so one rendering can be delivered at several
+// rates (e.g. 48 kHz PCM and 8 kHz mu-law) without running the Klatt
+// filters again. It works on a stream of blocks of any size and can be
+// put in front of any PcmSink.
+// =====================================================================
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "synthesizer.h"
+
+#define RESAMPLER_TAPS 32    // Filter taps per phase when not decimating
+#define RESAMPLER_CHUNK 512  // Input samples filtered per pass
+#define RESAMPLER_CUTOFF 0.9 // Passband edge as a fraction of the lower Nyquist frequency
+
+typedef struct {
+    int input_rate;
+    int output_rate;
+    int up;             // output_rate / input_rate reduced to up / down
+    int down;
+    int taps;           // Taps per phase, a multiple of 8
+    float *coefficients; // up phases of taps coefficients, each in input order
+    float *history;     // taps - 1 previous samples followed by the current chunk
+    int16_t *output;    // Output of one chunk
+    int next_input;     // Input sample of the next output, relative to the chunk
+    int phase;          // Filter phase of the next output
+    int skip;           // Outputs still to drop to remove the filter delay
+} Resampler;
+
+// PcmSink adapter: resamples every block and passes it on to sink
+typedef struct {
+    Resampler resampler;
+    PcmSink sink;
+    void *user_data;
+} ResamplerSink;
+
+int resampler_init(Resampler *resampler, int input_rate, int output_rate);
+void resampler_free(Resampler *resampler);
+void resampler_reset(Resampler *resampler);
+int resampler_process(Resampler *resampler, const int16_t *input, int num_input, PcmSink sink, void *user_data);
+int resampler_flush(Resampler *resampler, PcmSink sink, void *user_data);
+int resample_pcm(const int16_t *input, int num_input, int input_rate, int output_rate, int16_t **output);
+
+int resampler_sink_init(ResamplerSink *resampler_sink, int input_rate, int output_rate, PcmSink sink, void *user_data);
+int resampler_sink(void *user_data, const int16_t *samples, int num_samples);
+int resampler_sink_finish(ResamplerSink *resampler_sink);
+void resampler_sink_free(ResamplerSink *resampler_sink);
+
+int pcm_sink_ulaw_file(void *user_data, const int16_t *samples, int num_samples);
+
+#endif // RESAMPLER_H
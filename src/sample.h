@@ -0,0 +1,103 @@
+/* sample.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Numeric type of the signal path: the glottal and noise sources, the
+// formant bank, the noise filter and the high-pass stage. It is chosen
+// at build time:
+//   (default)            double
+//   KLATT_SAMPLE_FLOAT   float, which halves the memory traffic and
+//                        doubles the SIMD width of the formant bank
+//   KLATT_SAMPLE_FIXED   fixed point for targets without a fast FPU:
+//                        samples are Q15 in an int32 (the resonators
+//                        gain up to ~40 dB, so plain 16-bit Q15 would
+//                        overflow), coefficients are Q30 and products
+//                        accumulate in int64
+// Control-rate values (frequencies, bandwidths, amplitudes and the
+// glottal phase) stay double, and the phrase buffer handed to the
+// output stage is double whatever the sample type.
+// =====================================================================
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stdint.h>
+#include <math.h>
+
+#if defined(KLATT_SAMPLE_FIXED) && defined(KLATT_SAMPLE_FLOAT)
+#error "define at most one of KLATT_SAMPLE_FIXED and KLATT_SAMPLE_FLOAT"
+#endif
+
+#if defined(KLATT_SAMPLE_FIXED)
+
+#define KLATT_SAMPLE_TYPE_NAME "fixed"
+#define KLATT_SAMPLE_BITS 15 // Fraction bits of a sample
+#define KLATT_COEF_BITS 30   // Fraction bits of a coefficient
+
+typedef int32_t klatt_sample;
+typedef int32_t klatt_coef;
+typedef int64_t klatt_acc; // Sum of coefficient * sample products
+
+static inline klatt_sample klatt_sample_from_double(double x) {
+    return (klatt_sample)lrint(x * (1 << KLATT_SAMPLE_BITS));
+}
+static inline double klatt_sample_to_double(klatt_sample x) {
+    return x * (1.0 / (1 << KLATT_SAMPLE_BITS));
+}
+static inline klatt_coef klatt_coef_from_double(double x) {
+    return (klatt_coef)lrint(x * (1 << KLATT_COEF_BITS));
+}
+static inline klatt_acc klatt_acc_from_sample(klatt_sample x) {
+    return (klatt_acc)x << KLATT_COEF_BITS;
+}
+static inline klatt_acc klatt_mul(klatt_coef c, klatt_sample x) {
+    return (klatt_acc)c * x;
+}
+// Rounds to the nearest sample
+static inline klatt_sample klatt_acc_to_sample(klatt_acc acc) {
+    return (klatt_sample)((acc + ((klatt_acc)1 << (KLATT_COEF_BITS - 1))) >> KLATT_COEF_BITS);
+}
+
+#else
+
+#if defined(KLATT_SAMPLE_FLOAT)
+#define KLATT_SAMPLE_TYPE_NAME "float"
+typedef float klatt_sample;
+#else
+#define KLATT_SAMPLE_TYPE_NAME "double"
+typedef double klatt_sample;
+#endif
+typedef klatt_sample klatt_coef;
+typedef klatt_sample klatt_acc;
+
+static inline klatt_sample klatt_sample_from_double(double x) { return (klatt_sample)x; }
+static inline double klatt_sample_to_double(klatt_sample x) { return x; }
+static inline klatt_coef klatt_coef_from_double(double x) { return (klatt_coef)x; }
+static inline klatt_acc klatt_acc_from_sample(klatt_sample x) { return x; }
+static inline klatt_acc klatt_mul(klatt_coef c, klatt_sample x) { return c * x; }
+static inline klatt_sample klatt_acc_to_sample(klatt_acc acc) { return acc; }
+
+#endif
+
+// One step of a two-pole resonator: x - a1 * y1 - a2 * y2
+static inline klatt_sample klatt_resonate(klatt_sample x, klatt_coef a1, klatt_coef a2, klatt_sample y1, klatt_sample y2) {
+    return klatt_acc_to_sample(klatt_acc_from_sample(x) - klatt_mul(a1, y1) - klatt_mul(a2, y2));
+}
+
+#endif // SAMPLE_H
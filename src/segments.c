@@ -0,0 +1,175 @@
+/* segments.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "lexicon.h"
+#include "segments.h"
+
+static int compare_segments(const void *a, const void *b) {
+    uintptr_t pa = (uintptr_t)((const WordSegment *)a)->diphones;
+    uintptr_t pb = (uintptr_t)((const WordSegment *)b)->diphones;
+    return (pa > pb) - (pa < pb);
+}
+
+int segment_store_build(SegmentStore *store, const KlattOptions *options) {
+    memset(store, 0, sizeof(*store));
+    if (options) {
+        store->options = *options;
+    } else {
+        default_klatt_options(&store->options);
+    }
+
+    store->segments = (WordSegment *)calloc(lexicon_num_words, sizeof(WordSegment));
+    if (store->segments == NULL) {
+        fprintf(stderr, "Error: Could not allocate the segment store.\n");
+        return -1;
+    }
+
+    KlattEngine engine;
+    if (initialize_synthesis_engine(&engine, &store->options) != 0) {
+        segment_store_free(store);
+        return -1;
+    }
+    store->crossfade_samples = engine.options.sample_rate * SEGMENT_CROSSFADE_MS / 1000;
+    for (int i = 0; i < lexicon_num_words; i++) {
+        WordSegment *segment = &store->segments[i];
+        segment->diphones = lexicon_words[i].diphones;
+        segment->num_diphones = *lexicon_words[i].num_diphones;
+        segment->num_samples = synthesize_phrase_samples(&engine, &segment->diphones, &segment->num_diphones, 1, &segment->samples);
+        if (segment->num_samples < 0) {
+            fprintf(stderr, "Error: Could not render word '%s'.\n", lexicon_words[i].name);
+            free_synthesis_engine(&engine);
+            segment_store_free(store);
+            return -1;
+        }
+        store->num_segments++;
+    }
+    free_synthesis_engine(&engine);
+    qsort(store->segments, store->num_segments, sizeof(WordSegment), compare_segments);
+    return 0;
+}
+
+void segment_store_free(SegmentStore *store) {
+    for (int i = 0; i < store->num_segments; i++) {
+        free(store->segments[i].samples);
+    }
+    free(store->segments);
+    store->segments = NULL;
+    store->num_segments = 0;
+}
+
+const WordSegment* segment_store_find(const SegmentStore *store, const Diphone *diphones, int num_diphones) {
+    int low = 0;
+    int high = store->num_segments - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        const WordSegment *segment = &store->segments[mid];
+        if (segment->diphones == diphones) {
+            return (segment->num_diphones == num_diphones) ? segment : NULL;
+        }
+        if ((uintptr_t)segment->diphones < (uintptr_t)diphones) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+int assemble_phrase_pcm(const SegmentStore *store, const Diphone* const* word_diphones, const int* num_diphones, int num_words, Arena *arena, int16_t **pcm) {
+    int pause_samples = store->options.sample_rate / 4; // A quarter second pause, as in synthesize_phrase_and_save()
+    const WordSegment *segments[num_words > 0 ? num_words : 1];
+    int total_samples = 0;
+    for (int j = 0; j < num_words; j++) {
+        segments[j] = segment_store_find(store, word_diphones[j], num_diphones[j]);
+        if (segments[j] == NULL) {
+            return -1;
+        }
+        total_samples += segments[j]->num_samples + ((j < num_words - 1) ? pause_samples : 0);
+    }
+
+    *pcm = (int16_t *)arena_alloc(arena, (size_t)(total_samples > 0 ? total_samples : 1) * sizeof(int16_t));
+    if (*pcm == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for phrase samples.\n");
+        return -1;
+    }
+
+    // The double samples are only needed until they are normalized
+    ArenaMark mark = arena_mark(arena);
+    double *audio_buffer = (double *)arena_alloc(arena, (size_t)(total_samples > 0 ? total_samples : 1) * sizeof(double));
+    if (audio_buffer == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for phrase audio buffer.\n");
+        return -1;
+    }
+    memset(audio_buffer, 0, (size_t)total_samples * sizeof(double));
+
+    int current_sample = 0;
+    for (int j = 0; j < num_words; j++) {
+        const WordSegment *segment = segments[j];
+        double *out = audio_buffer + current_sample;
+        memcpy(out, segment->samples, segment->num_samples * sizeof(double));
+
+        // Crossfade with the pause on each side of the word
+        int fade = store->crossfade_samples;
+        if (fade > segment->num_samples / 2) {
+            fade = segment->num_samples / 2;
+        }
+        for (int k = 0; k < fade; k++) {
+            double gain = (double)(k + 1) / (fade + 1);
+            if (j > 0) {
+                out[k] *= gain;
+            }
+            if (j < num_words - 1) {
+                out[segment->num_samples - 1 - k] *= gain;
+            }
+        }
+        // The pause is already zero
+        current_sample += segment->num_samples + ((j < num_words - 1) ? pause_samples : 0);
+    }
+
+    normalize_to_pcm(audio_buffer, *pcm, total_samples);
+    arena_rewind(arena, mark);
+    return total_samples;
+}
+
+int synthesize_phrase_and_save_segments(const SegmentStore *store, KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words) {
+    // The samples are scratch memory of the engine, released on return
+    ArenaMark mark = arena_mark(&engine->scratch);
+    int16_t *pcm = NULL;
+    int num_samples = -1;
+    // The store only matches an engine configured the same way
+    if (memcmp(&store->options, &engine->options, sizeof(KlattOptions)) == 0) {
+        num_samples = assemble_phrase_pcm(store, word_diphones, num_diphones, num_words, &engine->scratch, &pcm);
+    }
+    if (num_samples < 0) {
+        arena_rewind(&engine->scratch, mark);
+        return synthesize_phrase_and_save(engine, filename, word_diphones, num_diphones, num_words);
+    }
+
+    KLATT_STATS_START(write_start);
+    int result = write_wav_file(filename, pcm, num_samples, store->options.sample_rate);
+    KLATT_STATS_STOP(&engine->stats, wav_write_ns, write_start);
+    KLATT_STATS_ADD(&engine->stats, wav_files, 1);
+    arena_rewind(&engine->scratch, mark);
+    return (result == 0) ? num_samples : -1;
+}
@@ -0,0 +1,72 @@
+/* segments.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Store of pre-rendered words. Every word in the lexicon is synthesized
+// once, and a phrase is then assembled by copying its words into place
+// with the usual pause between them. Each word is faded in and out over
+// a few milliseconds where it meets the pause, so the filter ringing cut
+// off at the ends of a segment does not click. Phrases containing a
+// word that is not in the store fall back to full synthesis.
+// =====================================================================
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include "phonemes.h"
+#include "synthesizer.h"
+
+#define SEGMENT_CROSSFADE_MS 2
+
+// One word rendered from a freshly reset engine, before normalization
+typedef struct {
+    const Diphone *diphones; // The word's diphone array identifies it
+    int num_diphones;
+    double *samples;
+    int num_samples;
+} WordSegment;
+
+// Built once and then only read, so threads can share it without locks
+typedef struct {
+    WordSegment *segments; // Sorted by diphone array address
+    int num_segments;
+    KlattOptions options; // Options the words were rendered with
+    int crossfade_samples;
+} SegmentStore;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+
+// Renders every lexicon word with an engine using options (NULL for
+// defaults). Returns -1 on error.
+int segment_store_build(SegmentStore *store, const KlattOptions *options);
+void segment_store_free(SegmentStore *store);
+const WordSegment* segment_store_find(const SegmentStore *store, const Diphone *diphones, int num_diphones);
+
+// Assembles a phrase from stored words as normalized 16-bit samples.
+// Returns the number of samples and sets *pcm to a buffer in arena
+// memory, or returns -1 if a word is not in the store.
+int assemble_phrase_pcm(const SegmentStore *store, const Diphone* const* word_diphones, const int* num_diphones, int num_words, Arena *arena, int16_t **pcm);
+
+// synthesize_phrase_and_save() that assembles the phrase from the store
+// when it can and synthesizes it otherwise
+int synthesize_phrase_and_save_segments(const SegmentStore *store, KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words);
+
+#endif // SEGMENTS_H
@@ -0,0 +1,72 @@
+/* stats.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include "stats.h"
+#include "sample.h"
+
+// Monotonic time in nanoseconds
+uint64_t klatt_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Adds the counters of stats to total, e.g. to sum the engines of a batch
+void klatt_stats_merge(KlattStats *total, const KlattStats *stats) {
+    total->frames += stats->frames;
+    total->coefficient_computations += stats->coefficient_computations;
+    total->coefficient_cache_hits += stats->coefficient_cache_hits;
+    total->source_samples += stats->source_samples;
+    total->formant_samples += stats->formant_samples;
+    total->high_pass_samples += stats->high_pass_samples;
+    total->source_ns += stats->source_ns;
+    total->formant_ns += stats->formant_ns;
+    total->high_pass_ns += stats->high_pass_ns;
+    total->wav_write_ns += stats->wav_write_ns;
+    total->wav_files += stats->wav_files;
+    if (stats->arena_high_water > total->arena_high_water) {
+        total->arena_high_water = stats->arena_high_water;
+    }
+    total->arena_blocks += stats->arena_blocks;
+}
+
+// Writes the counters as a JSON object. "enabled" is false, and every
+// counter but the arena sizes zero, in builds without KLATT_STATS.
+void klatt_stats_write_json(FILE *out, const KlattStats *stats) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"enabled\": %s,\n", KLATT_STATS_ENABLED ? "true" : "false");
+    fprintf(out, "  \"sample_type\": \"%s\",\n", KLATT_SAMPLE_TYPE_NAME);
+    fprintf(out, "  \"frames\": %llu,\n", (unsigned long long)stats->frames);
+    fprintf(out, "  \"coefficient_computations\": %llu,\n", (unsigned long long)stats->coefficient_computations);
+    fprintf(out, "  \"coefficient_cache_hits\": %llu,\n", (unsigned long long)stats->coefficient_cache_hits);
+    fprintf(out, "  \"samples\": {\"source\": %llu, \"formants\": %llu, \"high_pass\": %llu},\n",
+            (unsigned long long)stats->source_samples, (unsigned long long)stats->formant_samples,
+            (unsigned long long)stats->high_pass_samples);
+    fprintf(out, "  \"ns\": {\"source\": %llu, \"formants\": %llu, \"high_pass\": %llu, \"wav_write\": %llu},\n",
+            (unsigned long long)stats->source_ns, (unsigned long long)stats->formant_ns,
+            (unsigned long long)stats->high_pass_ns, (unsigned long long)stats->wav_write_ns);
+    fprintf(out, "  \"wav_files\": %llu,\n", (unsigned long long)stats->wav_files);
+    fprintf(out, "  \"arena\": {\"high_water_bytes\": %llu, \"blocks\": %llu}\n",
+            (unsigned long long)stats->arena_high_water, (unsigned long long)stats->arena_blocks);
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,67 @@
+/* stats.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Instrumentation of the synthesis hot path. Each engine counts the
+// frames it renders, the formant coefficient sets it computes, and the
+// samples and time spent in each stage: source generation, formant
+// bank, high-pass filter and WAV writing. The counters are compiled in
+// only when KLATT_STATS is defined (make DEFINES=-DKLATT_STATS), so the
+// default build pays nothing for them.
+// =====================================================================
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    uint64_t frames;                   // 10 ms frames rendered
+    uint64_t coefficient_computations; // Formant coefficient sets computed
+    uint64_t coefficient_cache_hits;   // Coefficient sets reused from the cache
+    uint64_t source_samples;           // Samples through each stage
+    uint64_t formant_samples;
+    uint64_t high_pass_samples;
+    uint64_t source_ns;                // Time spent in each stage
+    uint64_t formant_ns;
+    uint64_t high_pass_ns;
+    uint64_t wav_write_ns;
+    uint64_t wav_files;                // WAV files written
+    uint64_t arena_high_water;         // Most scratch bytes an utterance used, kept in every build
+    uint64_t arena_blocks;             // Scratch blocks allocated with malloc()
+} KlattStats;
+
+#ifdef KLATT_STATS
+#define KLATT_STATS_ENABLED 1
+#define KLATT_STATS_ADD(stats, field, n) ((stats)->field += (n))
+#define KLATT_STATS_START(timer) uint64_t timer = klatt_stats_now_ns()
+#define KLATT_STATS_STOP(stats, field, timer) ((stats)->field += klatt_stats_now_ns() - (timer))
+#else
+#define KLATT_STATS_ENABLED 0
+#define KLATT_STATS_ADD(stats, field, n) ((void)0)
+#define KLATT_STATS_START(timer) ((void)0)
+#define KLATT_STATS_STOP(stats, field, timer) ((void)0)
+#endif
+
+uint64_t klatt_stats_now_ns(void);
+void klatt_stats_merge(KlattStats *total, const KlattStats *stats);
+void klatt_stats_write_json(FILE *out, const KlattStats *stats);
+
+#endif // STATS_H
@@ -23,181 +23,298 @@
 // =====================================================================
 #include "synthesizer.h"
 #include "phonemes.h"
+#include "formants.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
+#include <limits.h>
 #include <time.h>
+#include <pthread.h>
 
 // =====================================================================================
-// Global Variables for the Synthesis Engine (defined here)
+// Synthesis Engine Functions
 // =====================================================================================
-double glottal_pulse_phase = 0.0;
-double glottal_pulse_last_sample = 0.0;
-unsigned int random_seed = 1;
 
-KlattFilter f1, f2, f3, f4, f5, f6; // Main formant filters for voiced source
-KlattFilter fn_noise;               // A separate parallel filter for the noise source
+// Fills in the default engine settings: coefficients are updated once
+// per frame, exactly as in the reference synthesizer
+void default_klatt_options(KlattOptions *options) {
+    options->coefficient_ramp = 0;
+    options->control_period_frames = 1;
+    options->sample_rate = SAMPLE_RATE;
+}
 
-// High-pass filter for DC offset removal
-double hp_a1 = 0.0;
-double hp_b0 = 0.0;
-double hp_b1 = 0.0;
-double hp_y1 = 0.0;
-double hp_x1 = 0.0;
+// Returns 1 if the engine can run at the rate
+int sample_rate_supported(int sample_rate) {
+    return sample_rate >= MIN_SAMPLE_RATE && sample_rate <= MAX_SAMPLE_RATE;
+}
 
-// =====================================================================================
-// Synthesis Engine Functions
-// =====================================================================================
+// Prepares an engine for use with the given settings (NULL for defaults).
+// Returns -1, leaving the engine at the default sample rate, if the
+// sample rate is not supported.
+int initialize_synthesis_engine(KlattEngine *engine, const KlattOptions *options) {
+    int result = 0;
+    if (options) {
+        engine->options = *options;
+    } else {
+        default_klatt_options(&engine->options);
+    }
+    if (engine->options.control_period_frames < 1) {
+        engine->options.control_period_frames = 1;
+    }
+    if (!sample_rate_supported(engine->options.sample_rate)) {
+        fprintf(stderr, "Error: Sample rate %d Hz is not supported (%d to %d Hz).\n",
+                engine->options.sample_rate, MIN_SAMPLE_RATE, MAX_SAMPLE_RATE);
+        engine->options.sample_rate = SAMPLE_RATE;
+        result = -1;
+    }
+
+    // Everything derived from the sample rate is computed once here
+    engine->dt = 1.0 / engine->options.sample_rate;
+    engine->frame_samples = engine->options.sample_rate * FRAME_PERIOD_MS / 1000;
+    engine->pause_samples = engine->options.sample_rate / 4;
+
+    memset(&engine->stats, 0, sizeof(engine->stats));
+    arena_create(&engine->scratch);
+    coefficient_cache_clear(&engine->coefficient_cache);
+    initialize_glottal_table();
+    reset_synthesis_engine_state(engine);
+    return result;
+}
 
 // Resets the state of the entire synthesis engine
-void reset_synthesis_engine_state() {
-    glottal_pulse_phase = 0.0;
-    glottal_pulse_last_sample = 0.0;
-    random_seed = 1;
+void reset_synthesis_engine_state(KlattEngine *engine) {
+    engine->glottal_pulse_phase = 0.0;
+    engine->glottal_pulse_last_sample = 0.0;
+    engine->random_seed = 1;
 
     // Reset all filters
-    initialize_filter(&f1, 0, 0);
-    initialize_filter(&f2, 0, 0);
-    initialize_filter(&f3, 0, 0);
-    initialize_filter(&f4, 0, 0);
-    initialize_filter(&f5, 0, 0);
-    initialize_filter(&f6, 0, 0);
-    initialize_filter(&fn_noise, 0, 0);
-    initialize_high_pass_filter();
+    formant_bank_reset(&engine->formants);
+    // Keep the counts of the cache before it is emptied
+    KLATT_STATS_ADD(&engine->stats, coefficient_computations, engine->coefficient_cache.misses);
+    KLATT_STATS_ADD(&engine->stats, coefficient_cache_hits, engine->coefficient_cache.hits);
+    coefficient_cache_clear(&engine->coefficient_cache);
+    initialize_filter(&engine->fn_noise, 0, 0, engine->dt);
+    initialize_high_pass_filter(engine);
 }
 
+// Returns the instrumentation counters of an engine, including the
+// coefficient cache of the current utterance
+void synthesis_engine_stats(const KlattEngine *engine, KlattStats *stats) {
+    *stats = engine->stats;
+    KLATT_STATS_ADD(stats, coefficient_computations, engine->coefficient_cache.misses);
+    KLATT_STATS_ADD(stats, coefficient_cache_hits, engine->coefficient_cache.hits);
+    stats->arena_high_water = engine->scratch.high_water;
+    stats->arena_blocks = engine->scratch.blocks_allocated;
+}
+
+// Releases the memory of an initialized engine
+void free_synthesis_engine(KlattEngine *engine) {
+    arena_destroy(&engine->scratch);
+}
 
-// Initializes the filter to a quiescent state
-void initialize_filter(KlattFilter *filter, double frequency, double bandwidth) {
-if (frequency == 0.0 || bandwidth == 0.0) {
+
+// Initializes the filter to a quiescent state. A resonance at or above
+// the Nyquist frequency would alias, so it switches the filter off.
+void initialize_filter(KlattFilter *filter, double frequency, double bandwidth, double dt) {
+if (frequency == 0.0 || bandwidth == 0.0 || frequency * dt >= 0.5) {
         filter->frequency = 0.0;
         filter->bandwidth = 0.0;
-        filter->a1 = 0.0;
-        filter->a2 = 0.0;
-        filter->y1 = 0.0;
-        filter->y2 = 0.0;
+        filter->a1 = 0;
+        filter->a2 = 0;
+        filter->y1 = 0;
+        filter->y2 = 0;
         return;
     }
     
-    double dt = 1.0 / SAMPLE_RATE;
     double r = exp(-M_PI * bandwidth * dt);
     double theta = 2 * M_PI * frequency * dt;
     filter->radius = r;
     filter->angle = theta;
-    filter->a1 = -2.0 * r * cos(theta);
-    filter->a2 = r * r;
-    filter->y1 = 0.0;
-    filter->y2 = 0.0;
+    filter->a1 = klatt_coef_from_double(-2.0 * r * cos(theta));
+    filter->a2 = klatt_coef_from_double(r * r);
+    filter->y1 = 0;
+    filter->y2 = 0;
     filter->frequency = frequency;
     filter->bandwidth = bandwidth;
 }
 
 // Updates a Klatt filter's coefficients without resetting state
-void update_filter_coefficients(KlattFilter *filter, double frequency, double bandwidth) {
-   if (frequency == 0.0 || bandwidth == 0.0) {
+void update_filter_coefficients(KlattFilter *filter, double frequency, double bandwidth, double dt) {
+   if (frequency == 0.0 || bandwidth == 0.0 || frequency * dt >= 0.5) {
         // If frequency or bandwidth is zero, turn off the filter.
         filter->frequency = 0.0;
         filter->bandwidth = 0.0;
-        filter->a1 = 0.0;
-        filter->a2 = 0.0;
+        filter->a1 = 0;
+        filter->a2 = 0;
         return;
     }
     
-    double dt = 1.0 / SAMPLE_RATE;
     double r = exp(-M_PI * bandwidth * dt);
     double theta = 2 * M_PI * frequency * dt;
     filter->radius = r;
     filter->angle = theta;
-    filter->a1 = -2.0 * r * cos(theta);
-    filter->a2 = r * r;
+    filter->a1 = klatt_coef_from_double(-2.0 * r * cos(theta));
+    filter->a2 = klatt_coef_from_double(r * r);
     filter->frequency = frequency;
     filter->bandwidth = bandwidth;
 }
 
 // Applies the filter to an input sample and returns the output
-double process_filter(KlattFilter *filter, double input) {
+klatt_sample process_filter(KlattFilter *filter, klatt_sample input) {
     if (filter->frequency == 0.0) {
         return input;
     }
-    double output = input - filter->a1 * filter->y1 - filter->a2 * filter->y2;
+    klatt_sample output = klatt_resonate(input, filter->a1, filter->a2, filter->y1, filter->y2);
     filter->y2 = filter->y1;
     filter->y1 = output;
     return output;
 }
 
-// Generates the glottal pulse derivative (Fant's model)
-double generate_glottal_pulse_derivative(double F0, double amplitude) {
+// Generates the glottal pulse derivative (Fant's model). Builds with
+// KLATT_GLOTTAL_WAVETABLE defined read the pulse from a precomputed
+// table instead of calling sin() for every sample.
+klatt_sample generate_glottal_pulse_derivative(KlattEngine *engine, double F0, double amplitude) {
+#ifdef KLATT_GLOTTAL_WAVETABLE
+    return glottal_pulse_derivative_wavetable(engine, F0, amplitude);
+#else
+    return glottal_pulse_derivative_analytic(engine, F0, amplitude);
+#endif
+}
+
+// Glottal pulse derivative computed directly from the pulse formula
+klatt_sample glottal_pulse_derivative_analytic(KlattEngine *engine, double F0, double amplitude) {
     if (F0 <= 0.0 || amplitude == 0.0) {
-        glottal_pulse_phase = 0.0;
-        glottal_pulse_last_sample = 0.0;
-        return 0.0;
+        engine->glottal_pulse_phase = 0.0;
+        engine->glottal_pulse_last_sample = 0.0;
+        return 0;
     }
 
     double T0 = 1.0 / F0; // Period
-    double dt = 1.0 / SAMPLE_RATE;
     
     // Increment the phase
-    glottal_pulse_phase += dt;
-    if (glottal_pulse_phase >= T0) {
-        glottal_pulse_phase -= T0;
+    engine->glottal_pulse_phase += engine->dt;
+    if (engine->glottal_pulse_phase >= T0) {
+        engine->glottal_pulse_phase -= T0;
     }
 
-    double alpha = 0.3; // Asymmetry parameter
-    double beta = 0.05; // Smoothing parameter
+    double alpha = GLOTTAL_ALPHA; // Asymmetry parameter
+    double beta = GLOTTAL_BETA; // Smoothing parameter
     double T_open = T0 * alpha; // Open phase duration
     double T_close = T0 * beta; // Closing phase duration
 
     double output;
-    if (glottal_pulse_phase < T_open) {
+    if (engine->glottal_pulse_phase < T_open) {
         // Opening phase
-        output = sin(M_PI * glottal_pulse_phase / T_open);
+        output = sin(M_PI * engine->glottal_pulse_phase / T_open);
     } else {
         // Closing phase
-        double t_prime = glottal_pulse_phase - T_open;
+        double t_prime = engine->glottal_pulse_phase - T_open;
         output = -sin(M_PI * t_prime / T_close);
     }
 
     // High-pass filter the glottal source to create the derivative-like shape
-    double hp_output = output - glottal_pulse_last_sample;
-    glottal_pulse_last_sample = output;
+    double hp_output = output - engine->glottal_pulse_last_sample;
+    engine->glottal_pulse_last_sample = output;
+
+    return klatt_sample_from_double(hp_output * amplitude);
+}
+
+// One period of the glottal pulse, with phase in cycles (0 to 1)
+static double glottal_pulse_shape(double phase) {
+    if (phase < GLOTTAL_ALPHA) {
+        // Opening phase
+        return sin(M_PI * phase / GLOTTAL_ALPHA);
+    }
+    // Closing phase
+    return -sin(M_PI * (phase - GLOTTAL_ALPHA) / GLOTTAL_BETA);
+}
+
+// The pulse shape only depends on the phase, so a single table serves
+// every F0. The extra entry lets interpolation read one past the end.
+static double glottal_table[GLOTTAL_TABLE_SIZE + 1];
+static pthread_once_t glottal_table_once = PTHREAD_ONCE_INIT;
+
+static void build_glottal_table(void) {
+    for (int i = 0; i <= GLOTTAL_TABLE_SIZE; i++) {
+        glottal_table[i] = glottal_pulse_shape((double)i / GLOTTAL_TABLE_SIZE);
+    }
+}
+
+// Fills the glottal pulse table once per process
+void initialize_glottal_table(void) {
+    pthread_once(&glottal_table_once, build_glottal_table);
+}
+
+// Glottal pulse derivative read from the wavetable with linear
+// interpolation. The phase accumulator advances exactly as in the
+// analytic source, but the period is only divided out when it wraps.
+klatt_sample glottal_pulse_derivative_wavetable(KlattEngine *engine, double F0, double amplitude) {
+    if (F0 <= 0.0 || amplitude == 0.0) {
+        engine->glottal_pulse_phase = 0.0;
+        engine->glottal_pulse_last_sample = 0.0;
+        return 0;
+    }
+
+    // Increment the phase
+    engine->glottal_pulse_phase += engine->dt;
+    double cycles = engine->glottal_pulse_phase * F0;
+    if (cycles >= 1.0) {
+        engine->glottal_pulse_phase -= 1.0 / F0;
+        cycles = engine->glottal_pulse_phase * F0;
+        // F0 can rise faster than the phase wraps during transitions
+        if (cycles >= 1.0) {
+            cycles -= floor(cycles);
+        }
+    }
+
+    double position = cycles * GLOTTAL_TABLE_SIZE;
+    int index = (int)position;
+    double fraction = position - index;
+    double output = glottal_table[index] + fraction * (glottal_table[index + 1] - glottal_table[index]);
+
+    // High-pass filter the glottal source to create the derivative-like shape
+    double hp_output = output - engine->glottal_pulse_last_sample;
+    engine->glottal_pulse_last_sample = output;
 
-    return hp_output * amplitude;
+    return klatt_sample_from_double(hp_output * amplitude);
 }
 
-double generate_noise_source(double amplitude) {
+klatt_sample generate_noise_source(KlattEngine *engine, double amplitude) {
     if (amplitude == 0.0) {
-        return 0.0;
+        return 0;
     }
     
     // Use a simple pseudo-random number generator
-    random_seed = random_seed * 1103515245 + 12345;
-    double random_val = ((double)random_seed / (double)UINT32_MAX) * 2.0 - 1.0;
+    engine->random_seed = engine->random_seed * 1103515245 + 12345;
+    double random_val = ((double)engine->random_seed / (double)UINT32_MAX) * 2.0 - 1.0;
     
     // Filter the noise with a simple pole
-    double noise_output = process_filter(&fn_noise, random_val);
+    klatt_sample noise_output = process_filter(&engine->fn_noise, klatt_sample_from_double(random_val));
 
-    return noise_output * amplitude;
+    return klatt_sample_from_double(klatt_sample_to_double(noise_output) * amplitude);
 }
 
 // High-pass filter initialization
-void initialize_high_pass_filter() {
+void initialize_high_pass_filter(KlattEngine *engine) {
     double cutoff_freq_hz = 50.0;
-    double theta_c = 2.0 * M_PI * cutoff_freq_hz / SAMPLE_RATE;
-    hp_a1 = (1.0 - theta_c) / (1.0 + theta_c);
-    hp_b0 = 0.5 * (1.0 + hp_a1);
-    hp_b1 = -0.5 * (1.0 + hp_a1);
-    hp_y1 = 0.0;
-    hp_x1 = 0.0;
+    double theta_c = 2.0 * M_PI * cutoff_freq_hz / engine->options.sample_rate;
+    double a1 = (1.0 - theta_c) / (1.0 + theta_c);
+    engine->hp_a1 = klatt_coef_from_double(a1);
+    engine->hp_b0 = klatt_coef_from_double(0.5 * (1.0 + a1));
+    engine->hp_b1 = klatt_coef_from_double(-0.5 * (1.0 + a1));
+    engine->hp_y1 = 0;
+    engine->hp_x1 = 0;
 }
 
 
 // High-pass filter to remove DC offset
-double process_high_pass_filter(double input) {
-    double output = hp_b0 * input + hp_b1 * hp_x1 - hp_a1 * hp_y1;
-    hp_y1 = output;
-    hp_x1 = input;
+klatt_sample process_high_pass_filter(KlattEngine *engine, klatt_sample input) {
+    klatt_sample output = klatt_acc_to_sample(klatt_mul(engine->hp_b0, input) + klatt_mul(engine->hp_b1, engine->hp_x1)
+                                              - klatt_mul(engine->hp_a1, engine->hp_y1));
+    engine->hp_y1 = output;
+    engine->hp_x1 = input;
     return output;
 }
 
@@ -228,138 +345,560 @@ PhonemeParams interpolate_params(const PhonemeParams *p1, const PhonemeParams *p
     return interpolated;
 }
 
-// Synthesizes a single frame of speech 
-void synthesize_frame(const PhonemeParams *params, double *audio_buffer, int *current_sample) {
-    
-    // Update the Klatt filter coefficients for the current frame
-    update_filter_coefficients(&f1, params->F1, params->B1);
-    update_filter_coefficients(&f2, params->F2, params->B2);
-    update_filter_coefficients(&f3, params->F3, params->B3);
-    update_filter_coefficients(&f4, params->F4, params->B4);
-    update_filter_coefficients(&f5, params->F5, params->B5);
-    update_filter_coefficients(&f6, params->F6, params->B6);
-    
-    // Determine the number of samples in this frame
-    int num_frame_samples = (int)(SAMPLE_RATE * FRAME_PERIOD_S);
-    
-    for (int i = 0; i < num_frame_samples; i++) {
+// =====================================================================
+// Growable audio buffer
+// =====================================================================
+
+// Starts an empty buffer; nothing is allocated until samples are added
+void audio_buffer_init(AudioBuffer *buffer) {
+    buffer->samples = NULL;
+    buffer->num_samples = 0;
+    buffer->capacity = 0;
+    buffer->fixed = 0;
+}
+
+// Starts an empty buffer over capacity samples owned by the caller. It
+// cannot grow, and audio_buffer_free() leaves the samples alone.
+void audio_buffer_init_fixed(AudioBuffer *buffer, double *samples, int capacity) {
+    buffer->samples = samples;
+    buffer->num_samples = 0;
+    buffer->capacity = capacity;
+    buffer->fixed = 1;
+}
+
+// Starts an empty buffer of capacity samples in arena memory. It is
+// released with the arena and cannot grow. Returns -1 if the memory
+// cannot be allocated.
+int audio_buffer_init_scratch(AudioBuffer *buffer, Arena *arena, int capacity) {
+    double *samples = (double *)arena_alloc(arena, (size_t)(capacity > 0 ? capacity : 1) * sizeof(double));
+    if (samples == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for audio buffer.\n");
+        audio_buffer_init(buffer);
+        return -1;
+    }
+    audio_buffer_init_fixed(buffer, samples, capacity);
+    return 0;
+}
+
+void audio_buffer_free(AudioBuffer *buffer) {
+    if (!buffer->fixed) {
+        free(buffer->samples);
+    }
+    audio_buffer_init(buffer);
+}
+
+// Makes room for num_samples more samples, at least doubling the
+// capacity when it grows so appending is amortized O(1). Returns -1
+// if the memory cannot be allocated.
+int audio_buffer_reserve(AudioBuffer *buffer, int num_samples) {
+    if (num_samples <= buffer->capacity - buffer->num_samples) {
+        return 0;
+    }
+    if (num_samples > INT_MAX - buffer->num_samples || buffer->fixed) {
+        fprintf(stderr, "Error: Audio buffer is too long.\n");
+        return -1;
+    }
+    int needed = buffer->num_samples + num_samples;
+    int capacity = (buffer->capacity > INT_MAX / 2) ? INT_MAX : buffer->capacity * 2;
+    if (capacity < needed) {
+        capacity = needed;
+    }
+    double *samples = (double *)realloc(buffer->samples, (size_t)capacity * sizeof(double));
+    if (samples == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for audio buffer.\n");
+        return -1;
+    }
+    buffer->samples = samples;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+// Adds num_samples samples to the end of the buffer and returns where
+// to write them, or NULL if the memory cannot be allocated
+double *audio_buffer_append(AudioBuffer *buffer, int num_samples) {
+    if (audio_buffer_reserve(buffer, num_samples) != 0) {
+        return NULL;
+    }
+    double *start = buffer->samples + buffer->num_samples;
+    buffer->num_samples += num_samples;
+    return start;
+}
+
+// Synthesizes a single frame of speech. Returns -1 if the output buffer
+// cannot grow.
+int synthesize_frame(KlattEngine *engine, const PhonemeParams *params, AudioBuffer *output) {
+    FormantCoefficients coefficients;
+    compute_formant_coefficients(params, engine->dt, &coefficients);
+    KLATT_STATS_ADD(&engine->stats, coefficient_computations, 1);
+    return synthesize_frame_with_coefficients(engine, params, &coefficients, output);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+// Renders one frame of frame_samples samples. It is inlined into a copy
+// per common frame size so those copies run with a constant loop count.
+static ALWAYS_INLINE void render_frame(KlattEngine *engine, const PhonemeParams *params, double *out, int frame_samples) {
+    klatt_sample source[MAX_FRAME_SAMPLES];
+    klatt_sample frame[MAX_FRAME_SAMPLES];
+
+    KLATT_STATS_START(source_start);
+    for (int i = 0; i < frame_samples; i++) {
         // Generate the glottal and noise sources
-        double voiced_source = generate_glottal_pulse_derivative(params->F0, params->AF);
-        double noise_source = generate_noise_source(params->AN);
+        klatt_sample voiced_source = generate_glottal_pulse_derivative(engine, params->F0, params->AF);
+        klatt_sample noise_source = generate_noise_source(engine, params->AN);
         
         // The total source is the sum of voiced and unvoiced sources
-        double total_source = voiced_source + noise_source;
-        
-        // Pass the source through the parallel Klatt filters
-        double output_f1 = process_filter(&f1, total_source);
-        double output_f2 = process_filter(&f2, total_source);
-        double output_f3 = process_filter(&f3, total_source);
-        double output_f4 = process_filter(&f4, total_source);
-        double output_f5 = process_filter(&f5, total_source);
-        double output_f6 = process_filter(&f6, total_source);
-        
-        // Sum the outputs of all parallel filters
-        double output_sample = (output_f1 + output_f2 + output_f3 + output_f4 + output_f5 + output_f6);
-        
+        source[i] = voiced_source + noise_source;
+    }
+
+    KLATT_STATS_STOP(&engine->stats, source_ns, source_start);
+
+    // Pass the source through the parallel Klatt filters and sum their outputs
+    KLATT_STATS_START(formant_start);
+    formant_bank_process_block(&engine->formants, source, frame, frame_samples);
+    KLATT_STATS_STOP(&engine->stats, formant_ns, formant_start);
+
+    KLATT_STATS_START(high_pass_start);
+    for (int i = 0; i < frame_samples; i++) {
         // Apply high-pass filter to remove DC offset
-        output_sample = process_high_pass_filter(output_sample);
-        
-        if (*current_sample < MAX_SAMPLES) {
-            audio_buffer[*current_sample] = output_sample;
+        out[i] = klatt_sample_to_double(process_high_pass_filter(engine, frame[i]));
+    }
+    KLATT_STATS_STOP(&engine->stats, high_pass_ns, high_pass_start);
+
+    KLATT_STATS_ADD(&engine->stats, frames, 1);
+    KLATT_STATS_ADD(&engine->stats, source_samples, frame_samples);
+    KLATT_STATS_ADD(&engine->stats, formant_samples, frame_samples);
+    KLATT_STATS_ADD(&engine->stats, high_pass_samples, frame_samples);
+}
+
+// Synthesizes a single frame of speech using precomputed formant coefficients.
+// Pass NULL coefficients to keep the current ones, e.g. while a ramp is in progress.
+int synthesize_frame_with_coefficients(KlattEngine *engine, const PhonemeParams *params, const FormantCoefficients *coefficients, AudioBuffer *output) {
+    double *out = audio_buffer_append(output, engine->frame_samples);
+    if (out == NULL) {
+        return -1;
+    }
+
+    // Update the Klatt filter coefficients for the current frame
+    if (coefficients) {
+        formant_bank_load(&engine->formants, coefficients);
+    }
+
+    // Specialized copies for 8, 16, 22.05 and 48 kHz
+    switch (engine->frame_samples) {
+        case 80: render_frame(engine, params, out, 80); break;
+        case 160: render_frame(engine, params, out, 160); break;
+        case 220: render_frame(engine, params, out, 220); break;
+        case 480: render_frame(engine, params, out, 480); break;
+        default: render_frame(engine, params, out, engine->frame_samples); break;
+    }
+    return 0;
+}
+
+// Returns the number of frames in a diphone
+int diphone_num_frames(const Diphone *diphone) {
+    return diphone->start_frames + diphone->transition_frames + diphone->end_frames;
+}
+
+// Synthesizes one frame of a diphone with coefficient ramping. Formant
+// coefficients are only computed at control points, every
+// control_period_frames frames of a transition, and are ramped per
+// sample in between. The source still follows the per-frame parameters.
+static int synthesize_diphone_frame_ramped(KlattEngine *engine, const Diphone *diphone, int frame, AudioBuffer *output) {
+    FormantBank *bank = &engine->formants;
+
+    if (frame < diphone->start_frames || frame >= diphone->start_frames + diphone->transition_frames) {
+        // Steady stages: ramp to the phoneme only if the bank is not already there
+        const PhonemeParams *params = (frame < diphone->start_frames) ? diphone->p1 : diphone->p2;
+        const FormantCoefficients *coefficients = coefficient_cache_lookup(&engine->coefficient_cache, params, engine->dt);
+        if (!formant_bank_has_coefficients(bank, coefficients)) {
+            formant_bank_start_ramp(bank, coefficients, engine->frame_samples);
         }
-        (*current_sample)++;
+        return synthesize_frame_with_coefficients(engine, params, NULL, output);
     }
+
+    int i = frame - diphone->start_frames;
+    int period = engine->options.control_period_frames;
+    if (i % period == 0) {
+        int end = (i + period < diphone->transition_frames) ? i + period : diphone->transition_frames;
+        PhonemeParams control = interpolate_params(diphone->p1, diphone->p2, diphone->transition_frames, end);
+        FormantCoefficients target;
+        compute_formant_coefficients(&control, engine->dt, &target);
+        KLATT_STATS_ADD(&engine->stats, coefficient_computations, 1);
+        formant_bank_start_ramp(bank, &target, (end - i) * engine->frame_samples);
+    }
+    PhonemeParams interpolated = interpolate_params(diphone->p1, diphone->p2, diphone->transition_frames, i);
+    return synthesize_frame_with_coefficients(engine, &interpolated, NULL, output);
 }
 
-// Synthesizes a single diphone and adds the output to a buffer
-void synthesize_diphone(const Diphone *diphone, double *audio_buffer, int *current_sample) {
-    // Calculate total frames for the diphone
-    //int total_frames = diphone->start_frames + diphone->transition_frames + diphone->end_frames;
+// Synthesizes one frame of a diphone, selected by its index, and
+// appends it to the output. Returns -1 if the output cannot grow.
+int synthesize_diphone_frame(KlattEngine *engine, const Diphone *diphone, int frame, AudioBuffer *output) {
+    if (engine->options.coefficient_ramp) {
+        return synthesize_diphone_frame_ramped(engine, diphone, frame, output);
+    }
+
+    if (frame < diphone->start_frames) {
+        // Stage 1: Initial phoneme (p1), its coefficients do not change between frames
+        const FormantCoefficients *coefficients = coefficient_cache_lookup(&engine->coefficient_cache, diphone->p1, engine->dt);
+        return synthesize_frame_with_coefficients(engine, diphone->p1, coefficients, output);
+    } else if (frame < diphone->start_frames + diphone->transition_frames) {
+        // Stage 2: Transition from p1 to p2
+        PhonemeParams interpolated = interpolate_params(diphone->p1, diphone->p2, diphone->transition_frames, frame - diphone->start_frames);
+        return synthesize_frame(engine, &interpolated, output);
+    } else {
+        // Stage 3: End phoneme (p2)
+        const FormantCoefficients *coefficients = coefficient_cache_lookup(&engine->coefficient_cache, diphone->p2, engine->dt);
+        return synthesize_frame_with_coefficients(engine, diphone->p2, coefficients, output);
+    }
+}
 
+// Synthesizes a single diphone and appends the output to a buffer.
+// Returns -1 if the output cannot grow.
+int synthesize_diphone(KlattEngine *engine, const Diphone *diphone, AudioBuffer *output) {
     if(DEBUG_PRINTF)
     printf("Synthesizing diphone with p1->F1: %f and p1->AF: %f\n", diphone->p1->F1, diphone->p1->AF);
-    
 
-    // Stage 1: Initial phoneme (p1)
-    for (int i = 0; i < diphone->start_frames; i++) {
-        synthesize_frame(diphone->p1, audio_buffer, current_sample);
+    int total_frames = diphone_num_frames(diphone);
+    if (audio_buffer_reserve(output, total_frames * engine->frame_samples) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < total_frames; i++) {
+        if (synthesize_diphone_frame(engine, diphone, i, output) != 0) {
+            return -1;
+        }
     }
+    return 0;
+}
 
-    // Stage 2: Transition from p1 to p2
-    for (int i = 0; i < diphone->transition_frames; i++) {
-        PhonemeParams interpolated = interpolate_params(diphone->p1, diphone->p2, diphone->transition_frames, i);
-        synthesize_frame(&interpolated, audio_buffer, current_sample);
+// Scales the audio buffer so that its peak is MAX_AMPLITUDE and
+// converts it to 16-bit samples
+void normalize_to_pcm(const double *buffer, int16_t *pcm, int num_samples) {
+    // Find the maximum absolute value for normalization. Four running
+    // maxima keep the iterations independent so the loop vectorizes.
+    double lane_max[4] = {0.0, 0.0, 0.0, 0.0};
+    int i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            double abs_val = fabs(buffer[i + k]);
+            lane_max[k] = (abs_val > lane_max[k]) ? abs_val : lane_max[k];
+        }
+    }
+    for (; i < num_samples; i++) {
+        double abs_val = fabs(buffer[i]);
+        lane_max[0] = (abs_val > lane_max[0]) ? abs_val : lane_max[0];
+    }
+    double max_abs = lane_max[0];
+    for (int k = 1; k < 4; k++) {
+        max_abs = (lane_max[k] > max_abs) ? lane_max[k] : max_abs;
     }
 
-    // Stage 3: End phoneme (p2)
-    for (int i = 0; i < diphone->end_frames; i++) {
-        synthesize_frame(diphone->p2, audio_buffer, current_sample);
+    double norm_factor = (max_abs > 0.0) ? MAX_AMPLITUDE / max_abs : 0.0;
+    for (i = 0; i < num_samples; i++) {
+        pcm[i] = (int16_t)(buffer[i] * norm_factor);
     }
-}
 
-// Function to write the WAV header
-void write_wav_header(FILE* file, int num_samples, int sample_rate) {
-    int num_channels = 1; // Mono
-    int byte_rate = sample_rate * num_channels * sizeof(int16_t);
-    int total_file_size = 36 + num_samples * num_channels * sizeof(int16_t);
-    
-    // RIFF chunk
-    fwrite("RIFF", 1, 4, file);
-    fwrite(&total_file_size, 4, 1, file);
-    fwrite("WAVE", 1, 4, file);
-    
-    // fmt chunk
-    fwrite("fmt ", 1, 4, file);
-    int fmt_chunk_size = 16;
-    fwrite(&fmt_chunk_size, 4, 1, file);
-    int audio_format = 1; // PCM
-    fwrite(&audio_format, 2, 1, file);
-    fwrite(&num_channels, 2, 1, file);
-    fwrite(&sample_rate, 4, 1, file);
-    fwrite(&byte_rate, 4, 1, file);
-    int block_align = num_channels * sizeof(int16_t);
-    fwrite(&block_align, 2, 1, file);
-    int bits_per_sample = 16;
-    fwrite(&bits_per_sample, 2, 1, file);
-    
-    // data chunk
-    fwrite("data", 1, 4, file);
-    int total_data_size = num_samples * sizeof(int16_t);
-    fwrite(&total_data_size, 4, 1, file);
+    if(DEBUG_PRINTF)
+    printf("Normalized %d samples. Max abs value: %f\n", num_samples, max_abs);
 }
 
 // Normalizes the audio buffer and writes it to a WAV file
 void normalize_and_write_to_file(const char* filename, double* buffer, int num_samples, int sample_rate) {
-    // Find the maximum absolute value for normalization
-    double max_abs = 0.0;
-    for (int i = 0; i < num_samples; i++) {
-        double abs_val = fabs(buffer[i]);
-        if (abs_val > max_abs) {
-            max_abs = abs_val;
+    int16_t *pcm = (int16_t *)malloc((num_samples > 0 ? num_samples : 1) * sizeof(int16_t));
+    if (pcm == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for samples for '%s'.\n", filename);
+        return;
+    }
+    normalize_to_pcm(buffer, pcm, num_samples);
+    write_wav_file(filename, pcm, num_samples, sample_rate);
+    free(pcm);
+}
+
+// =====================================================================
+// Helper function to synthesize a single word and save it to a file
+// =====================================================================
+int synthesize_word_and_save(KlattEngine *engine, const char* word_name, const Diphone* diphones, int num_diphones) {
+    int total_samples = 0;
+    for (int i = 0; i < num_diphones; i++) {
+        total_samples += diphone_num_frames(&diphones[i]) * engine->frame_samples;
+    }
+
+    // The buffers are scratch memory of the engine, released on return
+    ArenaMark mark = arena_mark(&engine->scratch);
+    AudioBuffer output;
+    int16_t *pcm = (int16_t *)arena_alloc(&engine->scratch, (size_t)(total_samples > 0 ? total_samples : 1) * sizeof(int16_t));
+    if (pcm == NULL || audio_buffer_init_scratch(&output, &engine->scratch, total_samples) != 0) {
+        fprintf(stderr, "Error: Could not allocate memory for samples for '%s'.\n", word_name);
+        arena_rewind(&engine->scratch, mark);
+        return -1;
+    }
+
+    // Synthesize the diphones into the buffer
+    for (int i = 0; i < num_diphones; i++) {
+        if (synthesize_diphone(engine, &diphones[i], &output) != 0) {
+            arena_rewind(&engine->scratch, mark);
+            return -1;
         }
     }
     
-    // Open the WAV file
-    FILE *file = fopen(filename, "wb");
-    if (!file) {
-        fprintf(stderr, "Error: Could not open file %s for writing.\n", filename);
-        return;
+    // Normalize and write the buffer to a WAV file
+    int num_samples = output.num_samples;
+    KLATT_STATS_START(write_start);
+    normalize_to_pcm(output.samples, pcm, num_samples);
+    write_wav_file(word_name, pcm, num_samples, engine->options.sample_rate);
+    KLATT_STATS_STOP(&engine->stats, wav_write_ns, write_start);
+    KLATT_STATS_ADD(&engine->stats, wav_files, 1);
+
+    arena_rewind(&engine->scratch, mark);
+    return num_samples;
+}
+
+// Number of samples in a phrase, with a quarter second pause between words
+static int phrase_num_samples(const KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words) {
+    int total_duration_samples = 0;
+    for (int j = 0; j < num_words; j++) {
+        for (int i = 0; i < num_diphones[j]; i++) {
+            total_duration_samples += diphone_num_frames(&word_diphones[j][i]) * engine->frame_samples;
+        }
+        if (j < num_words - 1) {
+            total_duration_samples += engine->pause_samples;
+        }
     }
-    
-    // Write the WAV header
-    write_wav_header(file, num_samples, sample_rate);
-    
-    // Normalize and convert to 16-bit integers, then write to file
-    double norm_factor = (max_abs > 0.0) ? MAX_AMPLITUDE / max_abs : 0.0;
-    int16_t sample_int;
-    for (int i = 0; i < num_samples; i++) {
-        sample_int = (int16_t)(buffer[i] * norm_factor);
-        fwrite(&sample_int, 2, 1, file);
+    return total_duration_samples;
+}
+
+// Synthesizes a phrase, with a quarter second pause between words,
+// before normalization into output, which must have room for
+// phrase_num_samples(). Returns -1 on error.
+static int render_phrase(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, AudioBuffer *output) {
+    int pause_samples = engine->pause_samples; // A quarter second pause
+
+  // Reset the synthesis engine state 
+    reset_synthesis_engine_state(engine);
+
+    // Synthesize each word and add a pause
+    for (int j = 0; j < num_words; j++) {
+        for (int i = 0; i < num_diphones[j]; i++) {
+            if (synthesize_diphone(engine, &word_diphones[j][i], output) != 0) {
+                return -1;
+            }
+        }
+        // Add a pause between words
+        if (j < num_words - 1) {
+            double *pause = audio_buffer_append(output, pause_samples);
+            if (pause == NULL) {
+                return -1;
+            }
+            memset(pause, 0, pause_samples * sizeof(double));
+        }
     }
-    
-    fclose(file);
-    
+    return 0;
+}
+
+// =====================================================================
+// Helper function to synthesize a phrase, with a quarter second pause
+// between words, before normalization. Returns the number of samples
+// and sets *samples to a buffer the caller frees, or returns -1.
+// =====================================================================
+int synthesize_phrase_samples(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, double **samples) {
+    // Render straight into the returned buffer, sized for the whole phrase
+    int total_samples = phrase_num_samples(engine, word_diphones, num_diphones, num_words);
+    double *buffer = (double *)malloc((total_samples > 0 ? total_samples : 1) * sizeof(double));
+    if (buffer == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for phrase samples.\n");
+        return -1;
+    }
+    AudioBuffer output;
+    audio_buffer_init_fixed(&output, buffer, total_samples);
+    if (render_phrase(engine, word_diphones, num_diphones, num_words, &output) != 0) {
+        free(buffer);
+        return -1;
+    }
+    *samples = buffer;
+    return output.num_samples;
+}
+
+// =====================================================================
+// Helper function to synthesize a phrase to normalized 16-bit samples
+// in the engine's scratch arena. Returns the number of samples and sets
+// *pcm, which stays valid until the caller rewinds the arena to a mark
+// taken before the call, or returns -1.
+// =====================================================================
+int synthesize_phrase_pcm_scratch(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, int16_t **pcm) {
+    int total_samples = phrase_num_samples(engine, word_diphones, num_diphones, num_words);
+    *pcm = (int16_t *)arena_alloc(&engine->scratch, (size_t)(total_samples > 0 ? total_samples : 1) * sizeof(int16_t));
+    if (*pcm == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for phrase samples.\n");
+        return -1;
+    }
+
+    // The double samples are only needed until they are normalized
+    ArenaMark mark = arena_mark(&engine->scratch);
+    AudioBuffer output;
+    int result = audio_buffer_init_scratch(&output, &engine->scratch, total_samples);
+    if (result == 0) {
+        result = render_phrase(engine, word_diphones, num_diphones, num_words, &output);
+    }
+    if (result == 0) {
+        normalize_to_pcm(output.samples, *pcm, output.num_samples);
+    }
+    arena_rewind(&engine->scratch, mark);
+    return (result == 0) ? output.num_samples : -1;
+}
+
+// =====================================================================
+// Helper function to synthesize a phrase to normalized 16-bit samples.
+// Returns the number of samples and sets *pcm to a buffer the caller
+// frees, or returns -1. Used where the samples leave the engine, e.g. by
+// the library; internal callers use synthesize_phrase_pcm_scratch().
+// =====================================================================
+int synthesize_phrase_pcm(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, int16_t **pcm) {
+    int total_samples = phrase_num_samples(engine, word_diphones, num_diphones, num_words);
+    *pcm = (int16_t *)malloc((total_samples > 0 ? total_samples : 1) * sizeof(int16_t));
+    if (*pcm == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for phrase samples.\n");
+        return -1;
+    }
+
+    ArenaMark mark = arena_mark(&engine->scratch);
+    AudioBuffer output;
+    int result = audio_buffer_init_scratch(&output, &engine->scratch, total_samples);
+    if (result == 0) {
+        result = render_phrase(engine, word_diphones, num_diphones, num_words, &output);
+    }
+    if (result == 0) {
+        normalize_to_pcm(output.samples, *pcm, output.num_samples);
+    }
+    arena_rewind(&engine->scratch, mark);
+    if (result != 0) {
+        free(*pcm);
+        *pcm = NULL;
+        return -1;
+    }
+    return output.num_samples;
+}
+
+// =====================================================================
+// Helper function to synthesize a phrase and save it to a single file
+// =====================================================================
+int synthesize_phrase_and_save(KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words) {
+    // The samples are scratch memory of the engine, released on return
+    ArenaMark mark = arena_mark(&engine->scratch);
+    int16_t *pcm = NULL;
+    int num_samples = synthesize_phrase_pcm_scratch(engine, word_diphones, num_diphones, num_words, &pcm);
+    if (num_samples < 0) {
+        arena_rewind(&engine->scratch, mark);
+        return -1;
+    }
+
     if(DEBUG_PRINTF)
-    printf("Saved file: %s with %d samples. Max abs value: %f\n", filename, num_samples, max_abs);
-    
+    printf("Synthesis of phrase complete. Writing to %s.\n", filename);
+    KLATT_STATS_START(write_start);
+    int result = write_wav_file(filename, pcm, num_samples, engine->options.sample_rate);
+    KLATT_STATS_STOP(&engine->stats, wav_write_ns, write_start);
+    KLATT_STATS_ADD(&engine->stats, wav_files, 1);
+
+    arena_rewind(&engine->scratch, mark);
+    return (result == 0) ? num_samples : -1;
+}
+
+// =====================================================================
+// Streaming synthesis
+// =====================================================================
+
+// Converts a frame to 16-bit samples using a fixed gain, clipping
+// anything that would overflow
+void convert_frame_to_pcm(const double *frame, int16_t *pcm, int num_samples, double gain) {
+    for (int i = 0; i < num_samples; i++) {
+        double value = frame[i] * gain;
+        if (value > MAX_AMPLITUDE) {
+            value = MAX_AMPLITUDE;
+        } else if (value < -MAX_AMPLITUDE) {
+            value = -MAX_AMPLITUDE;
+        }
+        pcm[i] = (int16_t)value;
+    }
+}
+
+// Synthesizes a phrase and hands each frame to the sink as soon as it
+// has been rendered, so playback can start after the first frame.
+// Every block passed to the sink holds one 10 ms frame of samples. Unlike
+// synthesize_phrase_and_save() there is no peak normalization; the
+// samples are scaled by a fixed gain (STREAM_GAIN suits the built-in
+// voice). Returns the number of samples produced, or -1 if the sink
+// asked to stop.
+int synthesize_phrase_streaming(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, double gain, PcmSink sink, void *user_data) {
+    AudioBuffer frame;
+    int16_t pcm[MAX_FRAME_SAMPLES];
+    int pause_samples = engine->pause_samples; // A quarter second pause, as in synthesize_phrase_and_save()
+    int total_samples = 0;
+
+    ArenaMark mark = arena_mark(&engine->scratch);
+    if (audio_buffer_init_scratch(&frame, &engine->scratch, engine->frame_samples) != 0) {
+        return -1;
+    }
+    reset_synthesis_engine_state(engine);
+
+    for (int j = 0; j < num_words; j++) {
+        for (int i = 0; i < num_diphones[j]; i++) {
+            const Diphone *diphone = &word_diphones[j][i];
+            int total_frames = diphone_num_frames(diphone);
+            for (int f = 0; f < total_frames; f++) {
+                frame.num_samples = 0; // Reuse the one frame of storage
+                if (synthesize_diphone_frame(engine, diphone, f, &frame) != 0) {
+                    arena_rewind(&engine->scratch, mark);
+                    return -1;
+                }
+                convert_frame_to_pcm(frame.samples, pcm, frame.num_samples, gain);
+                if (sink(user_data, pcm, frame.num_samples) != 0) {
+                    arena_rewind(&engine->scratch, mark);
+                    return -1;
+                }
+                total_samples += frame.num_samples;
+            }
+        }
+        // Add a pause between words
+        if (j < num_words - 1) {
+            memset(pcm, 0, sizeof(pcm));
+            for (int k = 0; k < pause_samples; k += engine->frame_samples) {
+                int block = (pause_samples - k < engine->frame_samples) ? pause_samples - k : engine->frame_samples;
+                if (sink(user_data, pcm, block) != 0) {
+                    arena_rewind(&engine->scratch, mark);
+                    return -1;
+                }
+                total_samples += block;
+            }
+        }
+    }
+    arena_rewind(&engine->scratch, mark);
+    return total_samples;
+}
+
+// PcmSink that writes raw little-endian samples to the FILE* passed as
+// user data (for example stdout piped into aplay)
+int pcm_sink_file(void *user_data, const int16_t *samples, int num_samples) {
+    FILE *file = (FILE *)user_data;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // Swap the bytes a block at a time, as write_wav_file() does
+    int16_t swapped[256];
+    for (int start = 0; start < num_samples; start += 256) {
+        int count = (num_samples - start < 256) ? num_samples - start : 256;
+        for (int i = 0; i < count; i++) {
+            uint16_t sample = (uint16_t)samples[start + i];
+            swapped[i] = (int16_t)((sample << 8) | (sample >> 8));
+        }
+        if (fwrite(swapped, sizeof(int16_t), count, file) != (size_t)count) {
+            return -1;
+        }
+    }
+#else
+    if (fwrite(samples, sizeof(int16_t), num_samples, file) != (size_t)num_samples) {
+        return -1;
+    }
+#endif
+    return fflush(file);
 }
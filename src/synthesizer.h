@@ -28,16 +28,26 @@
 #include <math.h>
 #include <stdio.h>
 #include "phonemes.h"
+#include "formants.h"
+#include "arena.h"
+#include "stats.h"
+#include "wav.h"
 
 // =====================================================================================
 // Global Constants and Defines
 // =====================================================================================
-#define SAMPLE_RATE 16000
-#define MAX_SAMPLES (SAMPLE_RATE * 5) // 5 seconds max
+#define SAMPLE_RATE 16000 // Default sample rate
+#define MIN_SAMPLE_RATE 8000
+#define MAX_SAMPLE_RATE 48000
 #define MAX_AMPLITUDE 32767
 #define FRAME_PERIOD_MS 10
 #define FRAME_PERIOD_S (FRAME_PERIOD_MS / 1000.0)
+#define MAX_FRAME_SAMPLES (MAX_SAMPLE_RATE * FRAME_PERIOD_MS / 1000) // Samples in a frame at the highest rate
 #define SILENCE_DURATION_MS 200 // Duration of silence between words
+#define GLOTTAL_ALPHA 0.3 // Open phase of the glottal pulse, as a fraction of the period
+#define GLOTTAL_BETA 0.05 // Closing phase of the glottal pulse, as a fraction of the period
+#define GLOTTAL_TABLE_SIZE 4096 // Entries per period in the glottal pulse wavetable
+#define STREAM_GAIN 160.0 // Fixed gain for streaming output, keeps the loudest built-in word below clipping
 
 // Define this macro to enable debug printing
 //#define DEBUG_PRINTF 1
@@ -56,27 +66,103 @@ typedef struct {
     double bandwidth;
     double radius;
     double angle;
-    double a1;
-    double a2;
-    double y1;
-    double y2;
+    klatt_coef a1;
+    klatt_coef a2;
+    klatt_sample y1;
+    klatt_sample y2;
 } KlattFilter;
 
+// Engine settings chosen when the engine is initialized. They are kept
+// when the engine state is reset between utterances.
+typedef struct {
+    int coefficient_ramp;      // Ramp formant coefficients per sample between control points
+    int control_period_frames; // Frames between coefficient updates in transitions when ramping
+    int sample_rate;           // Output rate in Hz, MIN_SAMPLE_RATE to MAX_SAMPLE_RATE
+} KlattOptions;
+
+// Holds all of the mutable state of one synthesis voice. Every synthesis
+// function takes the engine it operates on, so independent engines can be
+// used concurrently from separate threads.
+typedef struct {
+    KlattOptions options;
+    double dt;         // Sample period, 1 / options.sample_rate
+    int frame_samples; // Samples per 10 ms frame (rounded down at 22.05 kHz)
+    int pause_samples; // Quarter second pause between words
+
+    double glottal_pulse_phase;
+    double glottal_pulse_last_sample;
+    unsigned int random_seed;
+
+    FormantBank formants;               // Main formant filters F1-F6, one per SIMD lane
+    CoefficientCache coefficient_cache; // Coefficients of steady phoneme segments
+    KlattFilter fn_noise;               // A separate parallel filter for the noise source
+
+    // High-pass filter for DC offset removal
+    klatt_coef hp_a1;
+    klatt_coef hp_b0;
+    klatt_coef hp_b1;
+    klatt_sample hp_y1;
+    klatt_sample hp_x1;
+
+    Arena scratch; // Audio buffers and diphone lists of the current utterance
+
+    KlattStats stats; // Counted only in KLATT_STATS builds, kept across resets
+} KlattEngine;
+
+// Output samples of the synthesizer. The buffer grows as frames are
+// appended, so the length of an utterance is only limited by memory,
+// unless it was given fixed storage, e.g. from the engine's arena.
+typedef struct {
+    double *samples;
+    int num_samples;
+    int capacity;
+    int fixed; // samples belongs to someone else and cannot grow
+} AudioBuffer;
+
+// Receives blocks of 16-bit samples from the streaming synthesizer.
+// Returns 0 to continue or nonzero to stop synthesis.
+typedef int (*PcmSink)(void *user_data, const int16_t *samples, int num_samples);
+
 // =====================================================================================
 // Function Prototypes
 // =====================================================================================
-void reset_synthesis_engine_state();
-void initialize_filter(KlattFilter *filter, double frequency, double bandwidth);
-void update_filter_coefficients(KlattFilter *filter, double frequency, double bandwidth);
-double process_filter(KlattFilter *filter, double input);
-double generate_glottal_pulse_derivative(double F0, double amplitude);
-double generate_noise_source(double amplitude);
-void initialize_high_pass_filter();
-double process_high_pass_filter(double input);
+void default_klatt_options(KlattOptions *options);
+int sample_rate_supported(int sample_rate);
+int initialize_synthesis_engine(KlattEngine *engine, const KlattOptions *options);
+void reset_synthesis_engine_state(KlattEngine *engine);
+void free_synthesis_engine(KlattEngine *engine);
+void synthesis_engine_stats(const KlattEngine *engine, KlattStats *stats);
+void initialize_filter(KlattFilter *filter, double frequency, double bandwidth, double dt);
+void update_filter_coefficients(KlattFilter *filter, double frequency, double bandwidth, double dt);
+klatt_sample process_filter(KlattFilter *filter, klatt_sample input);
+klatt_sample generate_glottal_pulse_derivative(KlattEngine *engine, double F0, double amplitude);
+klatt_sample glottal_pulse_derivative_analytic(KlattEngine *engine, double F0, double amplitude);
+void initialize_glottal_table(void);
+klatt_sample glottal_pulse_derivative_wavetable(KlattEngine *engine, double F0, double amplitude);
+klatt_sample generate_noise_source(KlattEngine *engine, double amplitude);
+void initialize_high_pass_filter(KlattEngine *engine);
+klatt_sample process_high_pass_filter(KlattEngine *engine, klatt_sample input);
 PhonemeParams interpolate_params(const PhonemeParams *p1, const PhonemeParams *p2, int total_frames, int current_frame);
-void synthesize_frame(const PhonemeParams *params, double *audio_buffer, int *current_sample);
-void synthesize_diphone(const Diphone *diphone, double *audio_buffer, int *current_sample);
+void audio_buffer_init(AudioBuffer *buffer);
+void audio_buffer_init_fixed(AudioBuffer *buffer, double *samples, int capacity);
+int audio_buffer_init_scratch(AudioBuffer *buffer, Arena *arena, int capacity);
+void audio_buffer_free(AudioBuffer *buffer);
+int audio_buffer_reserve(AudioBuffer *buffer, int num_samples);
+double *audio_buffer_append(AudioBuffer *buffer, int num_samples);
+int synthesize_frame(KlattEngine *engine, const PhonemeParams *params, AudioBuffer *output);
+int synthesize_frame_with_coefficients(KlattEngine *engine, const PhonemeParams *params, const FormantCoefficients *coefficients, AudioBuffer *output);
+int diphone_num_frames(const Diphone *diphone);
+int synthesize_diphone_frame(KlattEngine *engine, const Diphone *diphone, int frame, AudioBuffer *output);
+int synthesize_diphone(KlattEngine *engine, const Diphone *diphone, AudioBuffer *output);
+void normalize_to_pcm(const double *buffer, int16_t *pcm, int num_samples);
 void normalize_and_write_to_file(const char* filename, double* buffer, int num_samples, int sample_rate);
-void write_wav_header(FILE* file, int num_samples, int sample_rate);
+int synthesize_word_and_save(KlattEngine *engine, const char* word_name, const Diphone* diphones, int num_diphones);
+int synthesize_phrase_samples(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, double **samples);
+int synthesize_phrase_pcm_scratch(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, int16_t **pcm);
+int synthesize_phrase_pcm(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, int16_t **pcm);
+int synthesize_phrase_and_save(KlattEngine *engine, const char* filename, const Diphone* const* word_diphones, const int* num_diphones, int num_words);
+void convert_frame_to_pcm(const double *frame, int16_t *pcm, int num_samples, double gain);
+int synthesize_phrase_streaming(KlattEngine *engine, const Diphone* const* word_diphones, const int* num_diphones, int num_words, double gain, PcmSink sink, void *user_data);
+int pcm_sink_file(void *user_data, const int16_t *samples, int num_samples);
 
 #endif // SYNTHESIZER_H
@@ -0,0 +1,168 @@
+/* voicebank.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "voicebank.h"
+
+// The phoneme table is mapped straight onto PhonemeParams, so the host
+// must store doubles and integers the way the file does
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "voice bank files are little-endian; a byte-swapping loader is needed on this host"
+#endif
+
+// Checks that a table of count records of record_size bytes starting at
+// offset lies inside the file
+static int section_fits(size_t file_size, uint32_t offset, uint32_t count, size_t record_size) {
+    if (offset % VOICEBANK_ALIGN != 0 || offset > file_size) {
+        return 0;
+    }
+    return (size_t)count <= (file_size - offset) / record_size;
+}
+
+static const char* bank_string(const VoiceBank *bank, uint32_t offset) {
+    return (offset < bank->header->string_size) ? bank->strings + offset : NULL;
+}
+
+int voicebank_open(VoiceBank *bank, const char *path) {
+    memset(bank, 0, sizeof(*bank));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open voice bank %s.\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(VoiceBankHeader)) {
+        fprintf(stderr, "Error: %s is too small to be a voice bank.\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map voice bank %s.\n", path);
+        return -1;
+    }
+
+    const VoiceBankHeader *header = (const VoiceBankHeader *)base;
+    const char *problem = NULL;
+    if (memcmp(header->magic, VOICEBANK_MAGIC, sizeof(header->magic)) != 0) {
+        problem = "not a voice bank";
+    } else if (header->version != VOICEBANK_VERSION) {
+        problem = "unsupported version";
+    } else if (header->file_size != size) {
+        problem = "truncated file";
+    } else if (header->num_phonemes > UINT16_MAX
+               || !section_fits(size, header->phoneme_offset, header->num_phonemes, sizeof(PhonemeParams))
+               || !section_fits(size, header->phoneme_name_offset, header->num_phonemes, sizeof(uint32_t))
+               || !section_fits(size, header->word_offset, header->num_words, sizeof(VoiceBankWord))
+               || !section_fits(size, header->diphone_offset, header->num_diphones, sizeof(VoiceBankDiphone))
+               || !section_fits(size, header->string_offset, header->string_size, 1)) {
+        problem = "table outside the file";
+    } else if (header->string_size == 0
+               || ((const char *)base)[header->string_offset + header->string_size - 1] != '\0') {
+        problem = "unterminated string table";
+    }
+    if (problem != NULL) {
+        fprintf(stderr, "Error: Invalid voice bank %s (%s).\n", path, problem);
+        munmap(base, size);
+        return -1;
+    }
+
+    bank->base = (const unsigned char *)base;
+    bank->size = size;
+    bank->header = header;
+    bank->phonemes = (const PhonemeParams *)(bank->base + header->phoneme_offset);
+    bank->phoneme_names = (const uint32_t *)(bank->base + header->phoneme_name_offset);
+    bank->words = (const VoiceBankWord *)(bank->base + header->word_offset);
+    bank->diphones = (const VoiceBankDiphone *)(bank->base + header->diphone_offset);
+    bank->strings = (const char *)(bank->base + header->string_offset);
+    return 0;
+}
+
+void voicebank_close(VoiceBank *bank) {
+    if (bank->base != NULL) {
+        munmap((void *)bank->base, bank->size);
+    }
+    memset(bank, 0, sizeof(*bank));
+}
+
+// Binary search of the word table, which the compiler sorts by name
+int voicebank_find_word(const VoiceBank *bank, const char *name) {
+    int low = 0;
+    int high = (int)bank->header->num_words - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        const char *word = bank_string(bank, bank->words[mid].name);
+        if (word == NULL) {
+            return -1;
+        }
+        int order = strcmp(name, word);
+        if (order == 0) {
+            return mid;
+        }
+        if (order < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return -1;
+}
+
+const char* voicebank_word_name(const VoiceBank *bank, int word) {
+    return bank_string(bank, bank->words[word].name);
+}
+
+int voicebank_word_num_diphones(const VoiceBank *bank, int word) {
+    return (int)bank->words[word].num_diphones;
+}
+
+int voicebank_word_diphones(const VoiceBank *bank, int word, Diphone *diphones, int max_diphones) {
+    const VoiceBankWord *entry = &bank->words[word];
+    if (entry->num_diphones > (uint32_t)max_diphones
+        || entry->first_diphone > bank->header->num_diphones
+        || entry->num_diphones > bank->header->num_diphones - entry->first_diphone) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < entry->num_diphones; i++) {
+        const VoiceBankDiphone *record = &bank->diphones[entry->first_diphone + i];
+        const char *name = bank_string(bank, record->name);
+        if (name == NULL || record->p1 >= bank->header->num_phonemes || record->p2 >= bank->header->num_phonemes) {
+            return -1;
+        }
+        diphones[i].name = name;
+        diphones[i].p1 = &bank->phonemes[record->p1];
+        diphones[i].p2 = &bank->phonemes[record->p2];
+        diphones[i].start_frames = record->start_frames;
+        diphones[i].transition_frames = record->transition_frames;
+        diphones[i].end_frames = record->end_frames;
+    }
+    return (int)entry->num_diphones;
+}
@@ -0,0 +1,111 @@
+/* voicebank.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Compiled voice bank: the phoneme parameter table and the word to
+// diphone index in one little-endian file, with phonemes referred to
+// by integer ID instead of by pointer. The file is mapped read-only, so
+// every process using the same bank shares one copy in the page cache
+// and opening it only checks the header.
+//
+// Layout (all offsets are from the start of the file):
+//   VoiceBankHeader
+//   phoneme table   num_phonemes PhonemeParams records (17 doubles each)
+//   phoneme names   num_phonemes uint32 string offsets
+//   word table      num_words VoiceBankWord records, sorted by name
+//   diphone table   num_diphones VoiceBankDiphone records
+//   string table    NUL-terminated names
+// =====================================================================
+#ifndef VOICEBANK_H
+#define VOICEBANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "phonemes.h"
+
+#define VOICEBANK_MAGIC "KVB1"
+#define VOICEBANK_VERSION 1
+#define VOICEBANK_ALIGN 8 // Sections start on a multiple of this
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t file_size;
+    uint32_t num_phonemes;
+    uint32_t num_words;
+    uint32_t num_diphones;
+    uint32_t phoneme_offset;
+    uint32_t phoneme_name_offset;
+    uint32_t word_offset;
+    uint32_t diphone_offset;
+    uint32_t string_offset;
+    uint32_t string_size;
+} VoiceBankHeader;
+
+typedef struct {
+    uint32_t name;          // Offset into the string table
+    uint32_t first_diphone; // Index into the diphone table
+    uint32_t num_diphones;
+} VoiceBankWord;
+
+typedef struct {
+    uint32_t name;     // Offset into the string table
+    uint16_t p1;       // Start phoneme ID
+    uint16_t p2;       // End phoneme ID
+    uint16_t start_frames;
+    uint16_t transition_frames;
+    uint16_t end_frames;
+    uint16_t reserved;
+} VoiceBankDiphone;
+
+// An open voice bank. The pointers refer into the read-only mapping.
+typedef struct {
+    const unsigned char *base;
+    size_t size;
+    const VoiceBankHeader *header;
+    const PhonemeParams *phonemes;
+    const uint32_t *phoneme_names;
+    const VoiceBankWord *words;
+    const VoiceBankDiphone *diphones;
+    const char *strings;
+} VoiceBank;
+
+// =====================================================================================
+// Function Prototypes
+// =====================================================================================
+
+// Maps the voice bank at path. Returns -1 if it cannot be read or is
+// not a valid bank.
+int voicebank_open(VoiceBank *bank, const char *path);
+void voicebank_close(VoiceBank *bank);
+
+// Returns the index of the word with the given lexicon name (see
+// lexicon_normalize_word), or -1 if the bank does not contain it
+int voicebank_find_word(const VoiceBank *bank, const char *name);
+const char* voicebank_word_name(const VoiceBank *bank, int word);
+int voicebank_word_num_diphones(const VoiceBank *bank, int word);
+
+// Fills diphones with the diphone sequence of a word. The Diphone
+// pointers refer into the mapping and stay valid until the bank is
+// closed. Returns the number of diphones, or -1 if the word has more
+// than max_diphones or refers to a phoneme that is not in the bank.
+int voicebank_word_diphones(const VoiceBank *bank, int word, Diphone *diphones, int max_diphones);
+
+#endif // VOICEBANK_H
@@ -0,0 +1,225 @@
+/* voicebank_compile.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// Compiles the phoneme and word tables of phonemes.c into a voice bank
+// file (see voicebank.h).
+//
+//   ./voicebank_compile voice.kvb
+// =====================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexicon.h"
+#include "voicebank.h"
+
+#define MAX_STRING_TABLE 65536
+
+typedef struct {
+    char data[MAX_STRING_TABLE];
+    uint32_t size;
+} StringTable;
+
+// Adds s to the table unless it is already there. Returns its offset,
+// or -1 if the table is full.
+static long add_string(StringTable *table, const char *s) {
+    uint32_t offset = 0;
+    while (offset < table->size) {
+        if (strcmp(table->data + offset, s) == 0) {
+            return offset;
+        }
+        offset += (uint32_t)strlen(table->data + offset) + 1;
+    }
+    size_t len = strlen(s) + 1;
+    if (table->size + len > MAX_STRING_TABLE) {
+        return -1;
+    }
+    memcpy(table->data + table->size, s, len);
+    table->size += (uint32_t)len;
+    return offset;
+}
+
+// Little-endian writers, so the file is the same whatever the host
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void put_double(unsigned char *p, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(bits >> (8 * i));
+    }
+}
+
+static uint32_t align_up(uint32_t offset) {
+    return (offset + VOICEBANK_ALIGN - 1) / VOICEBANK_ALIGN * VOICEBANK_ALIGN;
+}
+
+static int compare_word_names(const void *a, const void *b) {
+    const LexiconWord *wa = &lexicon_words[*(const int *)a];
+    const LexiconWord *wb = &lexicon_words[*(const int *)b];
+    return strcmp(wa->name, wb->name);
+}
+
+static void put_phoneme(unsigned char *p, const PhonemeParams *params) {
+    const double fields[] = {
+        params->F0, params->F1, params->B1, params->F2, params->B2, params->F3, params->B3,
+        params->F4, params->B4, params->F5, params->B5, params->F6, params->B6,
+        params->FN, params->BN, params->AF, params->AN
+    };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        put_double(p + 8 * i, fields[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s OUTPUT.kvb\n", argv[0]);
+        return 1;
+    }
+
+    static StringTable strings;
+    int num_phonemes = lexicon_num_phonemes;
+    int num_words = lexicon_num_words;
+    uint32_t num_diphones = 0;
+    for (int w = 0; w < num_words; w++) {
+        num_diphones += (uint32_t)*lexicon_words[w].num_diphones;
+    }
+
+    // Words are stored sorted so the loader can binary search them
+    int *order = (int *)malloc(num_words * sizeof(int));
+    if (order == NULL) {
+        fprintf(stderr, "Error: Could not allocate word table.\n");
+        return 1;
+    }
+    for (int w = 0; w < num_words; w++) {
+        order[w] = w;
+    }
+    qsort(order, num_words, sizeof(int), compare_word_names);
+
+    VoiceBankHeader header;
+    memset(&header, 0, sizeof(header));
+    header.num_phonemes = (uint32_t)num_phonemes;
+    header.num_words = (uint32_t)num_words;
+    header.num_diphones = num_diphones;
+    header.phoneme_offset = align_up(sizeof(VoiceBankHeader));
+    header.phoneme_name_offset = align_up(header.phoneme_offset + num_phonemes * sizeof(PhonemeParams));
+    header.word_offset = align_up(header.phoneme_name_offset + num_phonemes * sizeof(uint32_t));
+    header.diphone_offset = align_up(header.word_offset + num_words * sizeof(VoiceBankWord));
+    header.string_offset = align_up(header.diphone_offset + num_diphones * sizeof(VoiceBankDiphone));
+
+    // The string table is filled while the records are written, so the
+    // buffer is sized for the largest possible table
+    unsigned char *file = (unsigned char *)calloc(header.string_offset + MAX_STRING_TABLE, 1);
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not allocate voice bank.\n");
+        free(order);
+        return 1;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < num_phonemes && ok; i++) {
+        long name = add_string(&strings, lexicon_phonemes[i].name);
+        ok = (name >= 0);
+        put_phoneme(file + header.phoneme_offset + i * sizeof(PhonemeParams), lexicon_phonemes[i].params);
+        put_u32(file + header.phoneme_name_offset + i * sizeof(uint32_t), (uint32_t)name);
+    }
+
+    uint32_t next_diphone = 0;
+    for (int i = 0; i < num_words && ok; i++) {
+        const LexiconWord *word = &lexicon_words[order[i]];
+        long name = add_string(&strings, word->name);
+        ok = (name >= 0);
+        unsigned char *record = file + header.word_offset + i * sizeof(VoiceBankWord);
+        put_u32(record + offsetof(VoiceBankWord, name), (uint32_t)name);
+        put_u32(record + offsetof(VoiceBankWord, first_diphone), next_diphone);
+        put_u32(record + offsetof(VoiceBankWord, num_diphones), (uint32_t)*word->num_diphones);
+
+        for (int d = 0; d < *word->num_diphones && ok; d++) {
+            const Diphone *diphone = &word->diphones[d];
+            int p1 = lexicon_phoneme_index(diphone->p1);
+            int p2 = lexicon_phoneme_index(diphone->p2);
+            long diphone_name = add_string(&strings, diphone->name);
+            if (p1 < 0 || p2 < 0 || diphone_name < 0) {
+                fprintf(stderr, "Error: Diphone %s of word %s cannot be stored.\n", diphone->name, word->name);
+                ok = 0;
+                break;
+            }
+            record = file + header.diphone_offset + next_diphone * sizeof(VoiceBankDiphone);
+            put_u32(record + offsetof(VoiceBankDiphone, name), (uint32_t)diphone_name);
+            put_u16(record + offsetof(VoiceBankDiphone, p1), (uint16_t)p1);
+            put_u16(record + offsetof(VoiceBankDiphone, p2), (uint16_t)p2);
+            put_u16(record + offsetof(VoiceBankDiphone, start_frames), (uint16_t)diphone->start_frames);
+            put_u16(record + offsetof(VoiceBankDiphone, transition_frames), (uint16_t)diphone->transition_frames);
+            put_u16(record + offsetof(VoiceBankDiphone, end_frames), (uint16_t)diphone->end_frames);
+            next_diphone++;
+        }
+    }
+    free(order);
+    if (!ok) {
+        fprintf(stderr, "Error: Voice bank not written.\n");
+        free(file);
+        return 1;
+    }
+
+    memcpy(file + header.string_offset, strings.data, strings.size);
+    header.string_size = strings.size;
+    header.file_size = header.string_offset + strings.size;
+
+    memcpy(file, VOICEBANK_MAGIC, sizeof(header.magic));
+    put_u32(file + offsetof(VoiceBankHeader, version), VOICEBANK_VERSION);
+    put_u32(file + offsetof(VoiceBankHeader, file_size), header.file_size);
+    put_u32(file + offsetof(VoiceBankHeader, num_phonemes), header.num_phonemes);
+    put_u32(file + offsetof(VoiceBankHeader, num_words), header.num_words);
+    put_u32(file + offsetof(VoiceBankHeader, num_diphones), header.num_diphones);
+    put_u32(file + offsetof(VoiceBankHeader, phoneme_offset), header.phoneme_offset);
+    put_u32(file + offsetof(VoiceBankHeader, phoneme_name_offset), header.phoneme_name_offset);
+    put_u32(file + offsetof(VoiceBankHeader, word_offset), header.word_offset);
+    put_u32(file + offsetof(VoiceBankHeader, diphone_offset), header.diphone_offset);
+    put_u32(file + offsetof(VoiceBankHeader, string_offset), header.string_offset);
+    put_u32(file + offsetof(VoiceBankHeader, string_size), header.string_size);
+
+    FILE *out = fopen(argv[1], "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Could not open file %s for writing.\n", argv[1]);
+        free(file);
+        return 1;
+    }
+    int written = (fwrite(file, 1, header.file_size, out) == header.file_size);
+    written = (fclose(out) == 0) && written;
+    free(file);
+    if (!written) {
+        fprintf(stderr, "Error: Could not write voice bank %s.\n", argv[1]);
+        return 1;
+    }
+
+    printf("Wrote %s: %d phonemes, %d words, %u diphones, %u bytes.\n",
+           argv[1], num_phonemes, num_words, num_diphones, header.file_size);
+    return 0;
+}
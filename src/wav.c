@@ -0,0 +1,192 @@
+/* wav.c
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "wav.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WAV_HOST_BIG_ENDIAN 1
+#else
+#define WAV_HOST_BIG_ENDIAN 0
+#endif
+
+static void put_le16(uint8_t *p, int value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+#define ULAW_BIAS 0x84
+#define ULAW_CLIP 32635
+
+// Encodes one sample as G.711 mu-law
+uint8_t linear_to_ulaw(int16_t sample) {
+    int sign = (sample < 0) ? 0x80 : 0x00;
+    int magnitude = (sample < 0) ? -(int)sample : sample;
+    if (magnitude > ULAW_CLIP) {
+        magnitude = ULAW_CLIP;
+    }
+    magnitude += ULAW_BIAS;
+
+    int exponent = 7;
+    for (int mask = 0x4000; (magnitude & mask) == 0 && exponent > 0; mask >>= 1) {
+        exponent--;
+    }
+    int mantissa = (magnitude >> (exponent + 3)) & 0x0F;
+    return (uint8_t)~(sign | (exponent << 4) | mantissa);
+}
+
+// Serializes the header of a mono WAV file with 16-bit PCM or 8-bit
+// mu-law samples. Non-PCM files get the 18 byte fmt chunk and the fact
+// chunk they require. Returns the size of the header in bytes.
+int wav_encode_header(uint8_t *header, int format, int num_samples, int sample_rate) {
+    int bytes_per_sample = (format == WAV_FORMAT_PCM) ? 2 : 1;
+    int fmt_size = (format == WAV_FORMAT_PCM) ? 16 : 18;
+    uint32_t data_size = (uint32_t)num_samples * bytes_per_sample;
+
+    uint8_t *p = header;
+    memcpy(p, "RIFF", 4);
+    p += 8; // Size is filled in below
+    memcpy(p, "WAVEfmt ", 8);
+    put_le32(p + 8, fmt_size);
+    put_le16(p + 12, format);
+    put_le16(p + 14, 1); // Mono
+    put_le32(p + 16, sample_rate);
+    put_le32(p + 20, sample_rate * bytes_per_sample); // Byte rate
+    put_le16(p + 24, bytes_per_sample);               // Block align
+    put_le16(p + 26, 8 * bytes_per_sample);           // Bits per sample
+    p += 28;
+    if (format != WAV_FORMAT_PCM) {
+        put_le16(p, 0); // No extension
+        memcpy(p + 2, "fact", 4);
+        put_le32(p + 6, 4);
+        put_le32(p + 10, num_samples);
+        p += 14;
+    }
+    memcpy(p, "data", 4);
+    put_le32(p + 4, data_size);
+    p += 8;
+
+    int header_size = (int)(p - header);
+    // Chunks are padded to an even length
+    put_le32(header + 4, header_size - 8 + data_size + (data_size & 1));
+    return header_size;
+}
+
+// Writes the buffers to a new file with as few system calls as the
+// kernel allows. Returns -1 on error.
+static int write_file_vectors(const char *filename, struct iovec *vectors, int num_vectors) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open file %s for writing.\n", filename);
+        return -1;
+    }
+    while (num_vectors > 0) {
+        ssize_t written = writev(fd, vectors, num_vectors);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // Skip what was written, then retry the rest after a short write
+        while (num_vectors > 0 && (size_t)written >= vectors->iov_len) {
+            written -= vectors->iov_len;
+            vectors++;
+            num_vectors--;
+        }
+        if (num_vectors > 0) {
+            vectors->iov_base = (uint8_t *)vectors->iov_base + written;
+            vectors->iov_len -= written;
+        }
+    }
+    if (close(fd) != 0 || num_vectors > 0) {
+        fprintf(stderr, "Error: Could not write file %s.\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Writes 16-bit samples to a WAV file. Returns -1 on error.
+int write_wav_file(const char* filename, const int16_t *pcm, int num_samples, int sample_rate) {
+    uint8_t header[WAV_MAX_HEADER_SIZE];
+    int header_size = wav_encode_header(header, WAV_FORMAT_PCM, num_samples, sample_rate);
+
+    // The samples are already little-endian except on big-endian hosts
+    int16_t *swapped = NULL;
+    if (WAV_HOST_BIG_ENDIAN) {
+        swapped = (int16_t *)malloc((num_samples > 0 ? num_samples : 1) * sizeof(int16_t));
+        if (swapped == NULL) {
+            fprintf(stderr, "Error: Could not allocate memory for samples for '%s'.\n", filename);
+            return -1;
+        }
+        for (int i = 0; i < num_samples; i++) {
+            uint16_t sample = (uint16_t)pcm[i];
+            swapped[i] = (int16_t)((sample << 8) | (sample >> 8));
+        }
+        pcm = swapped;
+    }
+
+    struct iovec vectors[2] = {
+        {header, header_size},
+        {(void *)pcm, (size_t)num_samples * sizeof(int16_t)},
+    };
+    int result = write_file_vectors(filename, vectors, 2);
+    free(swapped);
+    return result;
+}
+
+// Writes 8-bit mu-law samples to a WAV file. Returns -1 on error.
+int write_ulaw_wav_file(const char *filename, const int16_t *pcm, int num_samples, int sample_rate) {
+    // One spare byte pads an odd length data chunk
+    uint8_t *data = (uint8_t *)malloc(num_samples + 1);
+    if (data == NULL) {
+        fprintf(stderr, "Error: Could not allocate memory for samples for '%s'.\n", filename);
+        return -1;
+    }
+    for (int i = 0; i < num_samples; i++) {
+        data[i] = linear_to_ulaw(pcm[i]);
+    }
+    data[num_samples] = 0;
+
+    uint8_t header[WAV_MAX_HEADER_SIZE];
+    int header_size = wav_encode_header(header, WAV_FORMAT_ULAW, num_samples, sample_rate);
+    struct iovec vectors[2] = {
+        {header, header_size},
+        {data, (size_t)num_samples + (num_samples & 1)},
+    };
+    int result = write_file_vectors(filename, vectors, 2);
+    free(data);
+    return result;
+}
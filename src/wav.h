@@ -0,0 +1,40 @@
+/* wav.h
+ *
+ * Copyright 2026 Alan Crispin <crispinalan@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+// =====================================================================
+// WAV file encoder. The header is serialized little-endian into a small
+// buffer and written together with the sample data in a single
+// writev() call, so writing an utterance costs one system call.
+// =====================================================================
+#ifndef WAV_H
+#define WAV_H
+
+#include <stdint.h>
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_ULAW 7
+#define WAV_MAX_HEADER_SIZE 58 // RIFF, fmt (18 bytes), fact and data chunk headers
+
+uint8_t linear_to_ulaw(int16_t sample);
+int wav_encode_header(uint8_t *header, int format, int num_samples, int sample_rate);
+int write_wav_file(const char* filename, const int16_t *pcm, int num_samples, int sample_rate);
+int write_ulaw_wav_file(const char *filename, const int16_t *pcm, int num_samples, int sample_rate);
+
+#endif // WAV_H